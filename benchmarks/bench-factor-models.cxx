@@ -0,0 +1,82 @@
+#include <desc/Component.hxx>
+#include <desc/Desc.hxx>
+#include <disc/Encoding.hxx>
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+using namespace sd::disc;
+
+// rows of two overlapping groups, each with its own block of correlated items
+template <typename S>
+Dataset<S> make_data(size_t rows, size_t dim, unsigned seed)
+{
+    std::mt19937                rng(seed);
+    std::bernoulli_distribution noise(0.15), signal(0.7);
+
+    Dataset<S> data;
+    itemset<S> t;
+    for (size_t i = 0; i < rows; ++i)
+    {
+        t.clear();
+        const size_t offset = (i % 2) * (dim / 3);
+        for (size_t j = 0; j < dim; ++j)
+        {
+            const bool in_block = j >= offset && j < offset + dim / 2;
+            if (in_block ? signal(rng) : noise(rng)) t.insert(j);
+        }
+        if (count(t) == 0) t.insert(dim - 1);
+        data.insert(t);
+    }
+    return data;
+}
+
+template <typename Distribution>
+void run(const char* name, size_t rows, size_t dim)
+{
+    using clock = std::chrono::steady_clock;
+    using trait = Trait<tag_dense, double, Distribution>;
+
+    Config cfg;
+    cfg.min_support      = 2;
+    cfg.max_factor_size  = 8;
+    cfg.max_factor_width = 12;
+
+    Component<trait> c;
+    c.data = make_data<tag_dense>(rows, dim, 7);
+
+    const auto start = clock::now();
+    initialize_model(c, cfg);
+    discover_patterns_generic(c, cfg, IDesc{});
+    const auto mined = clock::now();
+
+    // throughput of the model itself: evaluating the likelihood of every row
+    const size_t repeat = 20;
+    double       ll     = 0;
+    for (size_t r = 0; r < repeat; ++r) ll = static_cast<double>(log_likelihood(c.model, c.data));
+    const auto scored = clock::now();
+
+    const double t_desc  = std::chrono::duration<double>(mined - start).count();
+    const double t_score = std::chrono::duration<double>(scored - mined).count();
+
+    std::printf("%-8s rows=%-6zu dim=%-4zu |S|=%-4zu factors=%-4zu desc=%8.3fs "
+                "rows/s=%10.0f -log L=%.2f\n",
+                name,
+                rows,
+                dim,
+                c.summary.size(),
+                c.model.model.phi.factors.size(),
+                t_desc,
+                repeat * rows / t_score,
+                ll);
+}
+
+int main()
+{
+    for (auto [rows, dim] : {std::pair{200, 12}, std::pair{500, 16}, std::pair{1000, 20}})
+    {
+        run<MaxEntDistribution<tag_dense, double>>("maxent", rows, dim);
+        run<RelEntDistribution<tag_dense, double>>("relent", rows, dim);
+    }
+}
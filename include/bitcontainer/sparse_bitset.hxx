@@ -110,11 +110,21 @@ struct base_bitset_sparse : sparse_bit_view<C>
     template <typename T>
     void insert(const sd::sparse_bit_view<T>& rhs)
     {
-        auto&  a = this->container;
-        size_t n = a.size();
-        a.reserve(n + rhs.size());
-        a.insert(a.end(), rhs.container.begin(), rhs.container.end());
-        std::inplace_merge(a.begin(), a.begin() + n, a.end());
+        auto&       a = this->container;
+        const auto& b = rhs.container;
+        if (static_cast<const void*>(&a) == static_cast<const void*>(&b))
+            return;
+
+        // merge from the back, unlike std::inplace_merge this never allocates a buffer
+        size_t i = a.size(), j = b.size(), k = i + j;
+        a.resize(k);
+        while (j > 0)
+        {
+            if (i > 0 && b[j - 1] < a[i - 1])
+                a[--k] = a[--i];
+            else
+                a[--k] = b[--j];
+        }
         a.erase(std::unique(a.begin(), a.end()), a.end());
         // assert(std::is_sorted(container.begin(), container.end()));
     }
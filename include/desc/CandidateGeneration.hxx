@@ -150,6 +150,7 @@ struct CandidateGeneratorImpl
         // if (is_subset(other.pattern, next.pattern)) return 0;
 
         join(joined, next, other);
+        if (!row_weights.empty()) joined.support = support_of(joined.row_ids);
         if (joined.support < min_support) return 0;
 
         auto n = count(joined.pattern);
@@ -430,6 +431,17 @@ struct CandidateGeneratorImpl
         }
     }
 
+    /// number of rows of the original data in row_ids, counting duplicates
+    template <typename RowIds>
+    size_t support_of(const RowIds& row_ids) const
+    {
+        if (row_weights.empty()) return count(row_ids);
+        size_t s = 0;
+        foreach (row_ids, [&](size_t r) { s += row_weights[r]; })
+            ;
+        return s;
+    }
+
     bool   has_next() const { return !candidates.empty(); }
     size_t size() const { return candidates.size(); }
 
@@ -455,7 +467,14 @@ struct CandidateGeneratorImpl
             ++row_index;
         }
 
-        for (auto& s : singletons) { s.support = count(s.row_ids); }
+        row_weights.clear();
+        if (data.num_rows() != data.size())
+        {
+            row_weights.resize(data.size());
+            for (size_t r = 0; r < data.size(); ++r) row_weights[r] = data.weight(r);
+        }
+
+        for (auto& s : singletons) { s.support = support_of(s.row_ids); }
 
         singletons.erase(std::remove_if(singletons.begin(),
                                         singletons.end(),
@@ -472,6 +491,7 @@ struct CandidateGeneratorImpl
         if (other.support < min_support) return 0;
         if (next.support < min_support) return 0;
         join(joined, next, other);
+        if (!row_weights.empty()) joined.support = support_of(joined.row_ids);
         if (joined.support < min_support) return 0;
         joined.score = score(joined);
         return 1;
@@ -663,6 +683,7 @@ private:
     std::vector<state_type> singletons;
     std::vector<state_type> candidates;
     std::vector<state_type> novel;
+    std::vector<size_t>     row_weights; // empty if every row occurs once
 
     andres::RandomAccessSet<itemset<pattern_type>, lex_relation> known;
 
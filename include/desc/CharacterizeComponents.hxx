@@ -5,19 +5,36 @@
 #include <desc/Support.hxx>
 
 #include <limits>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
 
 namespace sd
 {
 namespace disc
 {
 
+struct TrueAssignment
+{
+    template <class... T>
+    bool confidence(T&&...) const
+    {
+        return true;
+    }
+};
+
+/// assignments whose confidence does not query the model; these do not need estimates
+/// while a component is characterized.
+template <typename Interface>
+constexpr bool is_trivial_assignment = std::is_same_v<std::decay_t<Interface>, TrueAssignment>;
+
 template <typename Trait, typename Interface = DefaultAssignment>
 void characterize_one_component(Composition<Trait>& c,
                                 size_t              index,
                                 const Config&       cfg,
                                 Interface&&         f = {})
 {
-    c.models[index] = make_distribution(c, cfg);
+    reset_distribution(c, c.models.overwrite(index), cfg);
     c.assignment[index].clear();
 
     using float_t = typename Trait::float_type;
@@ -41,30 +58,77 @@ void characterize_one_component(Composition<Trait>& c,
 
         if (is_singleton(x)) continue;
 
-        c.confidence(i, index) =
-            c.models[index].is_allowed(x) ? f.confidence(c, index, q, x, cfg) : float_t(0);
+        // patterns are only routed to their factors. a factor is solved before the
+        // confidence queries it and all remaining ones are solved once at the end.
+        const bool allowed = c.models[index].is_allowed(x);
+        if (allowed && !is_trivial_assignment<Interface>)
+            c.models[index].estimate_factors_of(x);
+
+        c.confidence(i, index) = allowed ? f.confidence(c, index, q, x, cfg) : float_t(0);
 
         if (c.confidence(i, index))
         {
             c.assignment[index].insert(i);
-            c.models[index].insert(q, x, true);
+            c.models[index].insert_deferred(q, x);
         }
     }
+
+    c.models[index].estimate_pending();
+}
+
+template <typename Summary>
+size_t fingerprint_of_summary(const Summary& summary)
+{
+    size_t h = summary.size();
+    for (size_t i = 0; i < summary.size(); ++i)
+    {
+        h = (h * 0x100000001b3) ^ fingerprint(summary.point(i));
+    }
+    return h;
 }
 
+/// re-characterizes only the components whose rows, summary, settings or model changed since
+/// their last characterization, or that were solved to a coarser sensitivity than cfg asks
+/// for; the others keep model, assignment and confidences.
 template <typename Trait, typename Interface = DefaultAssignment>
 void characterize_no_mining(Composition<Trait>& c, const Config& cfg, Interface&& f = {})
 {
     compute_frequency_matrix(c);
 
+    const size_t k        = c.data.num_components();
+    const size_t n        = c.summary.size();
+    const size_t summary  = fingerprint_of_summary(c.summary);
+    const size_t settings = model_fingerprint(cfg) ^ typeid(std::decay_t<Interface>).hash_code();
+
     c.confidence.clear();
-    c.confidence.resize(sd::layout<2>({c.summary.size(), c.data.num_components()}), 0);
-    c.assignment.assign(c.data.num_components(), {});
-    c.models.assign(c.data.num_components(), make_distribution(c, cfg));
+    c.confidence.resize(sd::layout<2>({n, k}), 0);
+    c.assignment.resize(k);
+    c.models.resize(k);
+    c.characterized.resize(k);
 
-    for (size_t j = 0; j < c.data.num_components(); ++j)
+    for (size_t j = 0; j < k; ++j)
     {
-        characterize_one_component(c, j, cfg, f);
+        auto&      s    = c.characterized[j];
+        const auto rows = c.data.fingerprint_of_subset(j);
+
+        if (s.version != std::as_const(c).models[j].version || s.rows != rows ||
+            s.summary != summary || s.settings != settings ||
+            s.sensitivity > cfg.scaling_sensitivity)
+        {
+            characterize_one_component(c, j, cfg, f);
+
+            s.rows        = rows;
+            s.summary     = summary;
+            s.settings    = settings;
+            s.sensitivity = cfg.scaling_sensitivity;
+            s.version     = c.models[j].version;
+            s.confidence.resize(n);
+            for (size_t i = 0; i < n; ++i) s.confidence[i] = c.confidence(i, j);
+        }
+        else
+        {
+            for (size_t i = 0; i < n; ++i) c.confidence(i, j) = s.confidence[i];
+        }
     }
 }
 
@@ -79,7 +143,7 @@ void characterize_components(Component<Trait>& c, const Config& cfg = {}, Interf
 {
     compute_frequency_matrix_column(c);
     c.confidence.assign(c.summary.size(), 0);
-    c.model = make_distribution(c, cfg);
+    reset_distribution(c, c.model, cfg);
 
     using float_t = typename Trait::float_type;
 
@@ -101,20 +165,16 @@ void characterize_components(Component<Trait>& c, const Config& cfg = {}, Interf
 
         if (is_singleton(x)) continue;
 
-        c.confidence[i] = c.model.is_allowed(x) ? f.confidence(c, q, x, cfg) : float_t(0);
+        const bool allowed = c.model.is_allowed(x);
+        if (allowed && !is_trivial_assignment<Interface>) c.model.estimate_factors_of(x);
 
-        if (c.confidence[0]) { c.model.insert(q, x, true); }
-    }
-}
+        c.confidence[i] = allowed ? f.confidence(c, q, x, cfg) : float_t(0);
 
-struct TrueAssignment
-{
-    template <class... T>
-    bool confidence(T&&...) const
-    {
-        return true;
+        if (c.confidence[0]) { c.model.insert_deferred(q, x); }
     }
-};
+
+    c.model.estimate_pending();
+}
 
 template <typename Trait, typename Interface = TrueAssignment>
 void initialize_model(Component<Trait>& c, const Config& cfg = {}, Interface&& f = {})
@@ -6,6 +6,8 @@
 #include <desc/distribution/Distribution.hxx>
 #include <desc/storage/Dataset.hxx>
 
+#include <memory>
+
 namespace sd::disc
 {
 
@@ -25,6 +27,9 @@ struct Component
     // EncodingLength<float_type> encoding;
     // EncodingLength<float_type> initial_encoding;
     distribution_type          model;
+    // solves of the model; shared with copies
+    std::shared_ptr<ScalingStatisticsCounter> scaling_statistics =
+        std::make_shared<ScalingStatisticsCounter>();
 
     // template <
     //     typename DATA,
@@ -2,8 +2,11 @@
 
 #include <desc/Settings.hxx>
 #include <desc/distribution/Distribution.hxx>
+#include <desc/storage/CopyOnWriteVector.hxx>
 #include <desc/storage/Dataset.hxx>
 #include <ndarray/ndarray.hxx>
+
+#include <memory>
 #include <vector>
 
 namespace sd
@@ -37,6 +40,39 @@ struct Trait
 
 using DefaultTrait = Trait<tag_dense, double, MaxEntDistribution<tag_dense, double>>;
 
+/// log-likelihood of a component, valid for the rows and model version it was computed for
+template <typename T>
+struct SubsetEncoding
+{
+    size_t rows    = 0;
+    size_t version = 0;
+    T      of_data = 0;
+};
+
+/// MDL costs of the patterns assigned to a component, see mdl::encode_summaries_expensive.
+/// valid for the rows and singleton frequencies they were computed for; each cost is also
+/// keyed by the fingerprint and frequency of its pattern.
+template <typename T>
+struct SubsetModelCost
+{
+    size_t              rows = 0;
+    std::vector<size_t> patterns;
+    std::vector<T>      frequencies;
+    std::vector<T>      of_pattern;
+};
+
+/// the inputs a model was characterized from; if they are unchanged, so is the model
+template <typename T>
+struct CharacterizedComponent
+{
+    size_t         rows        = 0;
+    size_t         summary     = 0;
+    size_t         settings    = 0;
+    double         sensitivity = 0; // the scaling sensitivity the model was solved to
+    size_t         version     = 0;
+    std::vector<T> confidence;
+};
+
 template <typename Trait>
 struct Composition
 {
@@ -53,8 +89,16 @@ struct Composition
     sd::ndarray<float_type, 2>     frequency;
     // EncodingLength<float_type>     encoding;
     // EncodingLength<float_type>     initial_encoding;
-    std::vector<distribution_type> models;
+    CopyOnWriteVector<distribution_type> models; // shared with copies until modified
     std::vector<tid_container> masks;
+
+    std::vector<CharacterizedComponent<float_type>> characterized;
+    mutable std::vector<SubsetEncoding<float_type>> subset_encodings;
+    mutable std::vector<SubsetModelCost<float_type>> subset_model_costs;
+
+    // solves of the models; copies share it, so that it counts their candidates as well
+    std::shared_ptr<ScalingStatisticsCounter> scaling_statistics =
+        std::make_shared<ScalingStatisticsCounter>();
 };
 
 template <typename T>
@@ -74,7 +118,17 @@ template <typename S>
 auto make_distribution(S const& c, Config const& cfg)
 {
     using distribution_type = typename S::distribution_type;
-    return distribution_type(c.data.dim, c.data.size(), cfg);
+    distribution_type m(c.data.dim, c.data.num_rows(), cfg);
+    m.count_scaling_into(c.scaling_statistics);
+    return m;
+}
+
+/// re-initializes m like make_distribution, but reuses its allocations
+template <typename S, typename D>
+void reset_distribution(S const& c, D& m, Config const& cfg)
+{
+    m.reset(c.data.dim, c.data.num_rows(), cfg);
+    m.count_scaling_into(c.scaling_statistics);
 }
 
 template <typename Trait>
@@ -102,5 +156,22 @@ auto construct_component_masks(const Composition<Trait>& c)
     return masks;
 }
 
+/// number of rows of the original data in row_ids that belong to component index
+template <typename Trait, typename RowIds>
+size_t support_in_component(const Composition<Trait>& c, const RowIds& row_ids, size_t index)
+{
+    if (!c.data.is_weighted()) return size_of_intersection(row_ids, c.masks[index]);
+
+    const auto a = c.data.positions[index];
+    const auto b = c.data.positions[index + 1];
+
+    size_t s = 0;
+    foreach (row_ids, [&](size_t r) {
+        if (a <= r && r < b) s += c.data.weight(r);
+    })
+        ;
+    return s;
+}
+
 } // namespace disc
 } // namespace sd
\ No newline at end of file
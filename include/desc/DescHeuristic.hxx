@@ -3,6 +3,8 @@
 #include <desc/Composition.hxx>
 #include <desc/Component.hxx>
 
+#include <algorithm>
+
 namespace sd::disc
 {
 
@@ -17,9 +19,10 @@ auto desc_heuristic_multi(const Composition<Trait>& c, const Candidate& x)
 
     for (size_t i = 0; i < c.data.num_components(); ++i)
     {
-        auto n = c.data.subset(i).size();
-        auto p = c.models[i].expectation(x.pattern);
-        auto s = size_of_intersection(x.row_ids, c.masks[i]);
+        auto n = c.data.num_rows(i);
+        // a solve that stopped at its tolerance can overshoot 1 by as much
+        auto p = std::min<float_type>(c.models[i].expectation(x.pattern), 1);
+        auto s = support_in_component(c, x.row_ids, i);
         auto q = static_cast<float_type>(s) / n;
         auto h = s == 0 ? 0 : s * log2(q / p);
 
@@ -39,9 +42,9 @@ auto desc_heuristic_1(const C& c, const Distribution& pr, const Candidate& x)
     using std::log2;
 
     const auto s = static_cast<float_type>(x.support);
-    const auto q = s / c.data.size();
-    const auto p = pr.expectation(x.pattern);
-    return s * log2(q / p) - log2(c.data.size());
+    const auto q = s / c.data.num_rows();
+    const auto p = std::min<float_type>(pr.expectation(x.pattern), 1);
+    return s * log2(q / p) - log2(c.data.num_rows());
 }
 
 template <typename Trait, typename Candidate>
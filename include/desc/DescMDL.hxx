@@ -26,10 +26,10 @@ auto constant_mdl_cost(Component<T> const& c, const X& x)
     typename T::float_type acc = 0;
     // each item in pattern:
     foreach (x, [&](size_t item) {
-        auto s = c.frequency[item] * c.data.size();
+        auto s = c.frequency[item] * c.data.num_rows();
         auto a = s == 0; 
         using std::log2;
-        acc -= log2((s + a) / (c.data.size() + a));
+        acc -= log2((s + a) / (c.data.num_rows() + a));
     })
         ;
     return acc + universal_code(count(x));
@@ -41,10 +41,10 @@ auto constant_mdl_cost(const Composition<T>& c, const X& x)
     typename T::float_type acc = 0;
 
     foreach (x, [&](size_t i) {
-        auto s = c.frequency(i, 0) * c.data.subset(0).size();
+        auto s = c.frequency(i, 0) * c.data.num_rows(0);
         auto a = s == 0;
         using std::log2;
-        acc -= log2((s + a) / (c.data.subset(0).size() + a));
+        acc -= log2((s + a) / (c.data.num_rows(0) + a));
     })
         ;
     acc += universal_code(count(x));
@@ -65,9 +65,10 @@ auto desc_heuristic_mdl_multi(const Composition<Trait>& c, const Candidate& x)
 
     for (size_t i = 0; i < c.data.num_components(); ++i)
     {
-        auto p = c.models[i].expectation(x.pattern);
-        auto s = size_of_intersection(x.row_ids, c.masks[i]);
-        auto q = static_cast<float_type>(s) / c.data.subset(i).size();
+        // a solve that stopped at its tolerance can overshoot 1 by as much
+        auto p = std::min<float_type>(c.models[i].expectation(x.pattern), 1);
+        auto s = support_in_component(c, x.row_ids, i);
+        auto q = static_cast<float_type>(s) / c.data.num_rows(i);
         using std::log2;
         auto h = s == 0 ? 0 : s * log2(q / p);
 
@@ -86,8 +87,8 @@ auto desc_heuristic_mdl_1(const C& c, const Distribution& pr, const Candidate& x
 
     // const auto s = static_cast<float_type>(x.support);
     const auto s = x.support;
-    const auto q = static_cast<float_type>(s) / c.data.size();
-    const auto p = pr.expectation(x.pattern);
+    const auto q = static_cast<float_type>(s) / c.data.num_rows();
+    const auto p = std::min<float_type>(pr.expectation(x.pattern), 1);
 
     assert(0 <= p && p <= 1);
     using std::log2;
@@ -48,8 +48,8 @@ void insert_pattern_to_summary(Composition<Trait>& c, const Candidate& x)
     auto new_q = c.frequency[c.frequency.extent(0) - 1];
     for (size_t j = 0; j < c.data.num_components(); ++j)
     {
-        auto s   = size_of_intersection(x.row_ids, c.masks[j]);
-        new_q(j) = static_cast<float_type>(s) / c.data.subset(j).size();
+        auto s   = support_in_component(c, x.row_ids, j);
+        new_q(j) = static_cast<float_type>(s) / c.data.num_rows(j);
     }
     // new_q.back() = glob_frequency;
 }
@@ -69,8 +69,8 @@ bool find_assignment_impl(Composition<Trait>& c,
     size_t counter = 0;
     for (size_t i = 0; i < c.data.num_components(); ++i)
     {
-        auto  s  = size_of_intersection(x.row_ids, c.masks[i]);
-        auto  q  = static_cast<float_type>(s) / c.data.subset(i).size();
+        auto  s  = support_in_component(c, x.row_ids, i);
+        auto  q  = static_cast<float_type>(s) / c.data.num_rows(i);
         auto& pr = c.models[i];
         conf[i]  = f.confidence(c, i, q, x.pattern, cfg);
         if (pr.is_allowed(x.pattern) && conf[i] > 0)
@@ -106,7 +106,7 @@ bool find_assignment_impl_first(Composition<Trait>& c, const Candidate& x, const
 
     if (x.score <= 0 || !c.models[0].is_allowed(x.pattern)) return false;
 
-    auto q = static_cast<float_type>(x.support) / c.data.size();
+    auto q = static_cast<float_type>(x.support) / c.data.num_rows();
 
     c.models[0].insert(q, x.pattern, true);
     c.assignment[0].insert(c.summary.size());
@@ -135,7 +135,7 @@ bool find_assignment(Component<Trait>& c, const Candidate& x, const Config&, Int
 
     if (x.score <= 0) return false;
 
-    auto q = static_cast<float_type>(x.support) / c.data.size();
+    auto q = static_cast<float_type>(x.support) / c.data.num_rows();
 
     c.model.insert(q, x.pattern, true);
     c.summary.insert(x.pattern);
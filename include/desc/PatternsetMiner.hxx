@@ -18,7 +18,7 @@ template <typename Trait, typename Candidate>
 bool is_allowed(const Composition<Trait>& c, const Candidate& x)
 {
     return std::any_of(
-        begin(c.models), end(c.models), [&](const auto& m) { return m.is_allowed(x.pattern); });
+        c.models.begin(), c.models.end(), [&](const auto& m) { return m.is_allowed(x.pattern); });
 }
 
 template <typename Trait, typename Config>
@@ -76,9 +76,12 @@ void discover_patterns_generic(C& s, const Config& cfg, I fn = {}, Info&& info =
 
     assert(s.data.dim != 0);
 
+    const auto scaling        = s.scaling_statistics;
+    const auto scaling_before = scaling->load();
+
     fn.prepare(s, cfg);
 
-    info(std::as_const(s));
+    invoke_callback(info, std::as_const(s), scaling->load() - scaling_before);
 
     auto score_fn = [&](auto& x) { return fn.heuristic(s, x, cfg); };
     auto prune_fn = [&](auto& x) { return x.score <= 0 || !fn.is_allowed(s, x, cfg); };
@@ -103,7 +106,7 @@ void discover_patterns_generic(C& s, const Config& cfg, I fn = {}, Info&& info =
             patience   = std::min(patience * 2, cfg.max_patience);
             items_used = items_used + 1;
 
-            info(std::as_const(s));
+            invoke_callback(info, std::as_const(s), scaling->load() - scaling_before);
         }
         else if (patience-- == 0)
             break;
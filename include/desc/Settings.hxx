@@ -1,6 +1,8 @@
 #pragma once
 
 #include <chrono>
+#include <functional>
+#include <limits>
 #include <optional>
 
 namespace sd
@@ -18,10 +20,38 @@ struct Config
     size_t max_factor_size  = 8;
     size_t max_iteration    = std::numeric_limits<size_t>::max();
 
+    double scaling_sensitivity = 1e-8;
+    // adaptive tolerance: models of candidate splits are only scored; they are estimated
+    // with scoring_sensitivity and re-estimated with scaling_sensitivity once accepted.
+    bool   adaptive_tolerance  = false;
+    double scoring_sensitivity = 1e-5;
+    // solve the factors in log-space: a stable double precision alternative to float128
+    bool   log_space_scaling   = false;
+    // prune factors by lazy instead of exact greedy selection; faster, but a heuristic
+    bool   lazy_factor_pruning = false;
+
     std::optional<size_t>                    max_pattern_size;
     std::optional<size_t>                    max_patternset_size;
     std::optional<std::chrono::milliseconds> max_time;
 };
 
+/// identifies the settings that a characterized model depends on, except for the scaling
+/// sensitivity: a model solved to a finer sensitivity also serves a coarser one
+inline size_t model_fingerprint(const Config& cfg)
+{
+    size_t h = 0xcbf29ce484222325;
+    for (size_t v : {cfg.max_factor_size, cfg.max_factor_width, size_t(cfg.log_space_scaling)})
+    {
+        h ^= v + 0x9e3779b97f4a7c15 + (h << 6) + (h >> 2);
+    }
+    return h;
+}
+
+inline Config scoring_config(Config cfg)
+{
+    if (cfg.adaptive_tolerance) cfg.scaling_sensitivity = cfg.scoring_sensitivity;
+    return cfg;
+}
+
 } // namespace disc
 } // namespace sd
\ No newline at end of file
@@ -16,6 +16,13 @@ size_t support(const P& x, const Data& es)
     return std::count_if(
         es.begin(), es.end(), [&](const auto& e) { return is_subset(x, point(e)); });
 }
+
+template <typename Summary>
+void compute_signatures(const Summary& summary, std::vector<signature_type>& out)
+{
+    out.resize(summary.size());
+    for (size_t i = 0; i < summary.size(); ++i) out[i] = signature(summary.point(i));
+}
 template <typename T, typename P, typename E>
 T frequency(const P& x, const E& es)
 {
@@ -57,9 +64,10 @@ std::vector<size_t> compute_singleton_supports(size_t dim, const DataType& data)
     for (size_t i = 0; i < data.size(); ++i)
     {
         assert(i < data.size());
+        const auto w = data.weight(i);
         foreach (data.point(i), [&](auto j) {
             assert(j < dim);
-            support[j]++;
+            support[j] += w;
         })
             ;
     }
@@ -105,18 +113,24 @@ void compute_frequency_matrix_column(Composition<Trait>& c, const size_t comp_in
     auto& summary = c.summary;
     auto& fr      = c.frequency;
 
+    thread_local std::vector<signature_type> sigs;
+    compute_signatures(summary, sigs);
+
     for (size_t i = 0; i < fr.extent(0); ++i) fr(i, comp_index) = 0;
 
-    auto component = data.subset(comp_index);
-    for (const auto& x : component)
+    const auto& rows      = data.underlying_data();
+    auto        component = data.subset(comp_index);
+    for (const auto& [_1, t, pos, st] : component)
     {
+        const auto w = rows.weight(pos);
         for (size_t i = 0; i < summary.size(); ++i)
         {
-            if (is_subset(summary.point(i), point(x))) { fr(i, comp_index) += 1; }
+            if (is_subset(summary.point(i), sigs[i], t, st)) { fr(i, comp_index) += w; }
         }
     }
 
-    for (size_t i = 0; i < summary.size(); ++i) { fr(i, comp_index) /= component.size(); }
+    const auto n = data.num_rows(comp_index);
+    for (size_t i = 0; i < summary.size(); ++i) { fr(i, comp_index) /= n; }
 }
 
 template <typename Trait>
@@ -140,17 +154,23 @@ void compute_frequency_matrix_column(Component<Trait>& c)
     auto& s    = c.summary;
     auto& fr   = c.frequency;
 
+    thread_local std::vector<signature_type> sigs;
+    compute_signatures(s, sigs);
+
     fr.assign(c.summary.size(), 0);
 
-    for (const auto& x : data)
+    for (size_t r = 0; r < data.size(); ++r)
     {
+        const auto& x  = data.point(r);
+        const auto  sx = signature(x);
+        const auto  w  = data.weight(r);
         for (size_t i = 0; i < s.size(); ++i)
         {
-            if (is_subset(s.point(i), point(x))) { fr[i] += 1; }
+            if (is_subset(s.point(i), sigs[i], x, sx)) { fr[i] += w; }
         }
     }
 
-    for (size_t i = 0; i < s.size(); ++i) { fr[i] /= data.size(); }
+    for (size_t i = 0; i < s.size(); ++i) { fr[i] /= data.num_rows(); }
 }
 
 // template <typename T, typename S>
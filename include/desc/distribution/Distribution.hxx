@@ -1,16 +1,29 @@
 #pragma once
 
+#include <desc/distribution/FactorTables.hxx>
 #include <desc/distribution/IterativeScaling.hxx>
 #include <desc/distribution/StaticFactorModel.hxx>
-//#include <desc/distribution/RelaxedFactorModel.hxx>
+#include <desc/distribution/RelaxedFactorModel.hxx>
 #include <desc/storage/Itemset.hxx>
 #include <desc/Settings.hxx>
 
+#include <atomic>
+#include <memory>
+#include <vector>
+
 namespace sd
 {
 namespace disc
 {
 
+/// process-wide unique versions: a value derived from a distribution stays valid as long as
+/// the version of the distribution is unchanged.
+inline size_t next_model_version()
+{
+    static std::atomic<size_t> counter{0};
+    return ++counter;
+}
+
 template <typename Model, typename X>
 auto log_expectation(Model const& m, X const& x)
 {
@@ -23,7 +36,14 @@ auto log_expectation(Model const& m, X const& x)
 
     float_type fr = 0;
     factorize(m, x, [&](const auto& f, size_t, bool s) {
-        if (s) { fr += log2(f.factor.singletons.set.front().probability); }
+        if constexpr (is_singleton_factor<std::decay_t<decltype(f)>>)
+        {
+            fr += log2(f.probability);
+        }
+        else if (s)
+        {
+            fr += log2(f.factor.singletons.probability(0));
+        }
         else
         {
             part.clear();
@@ -46,7 +66,14 @@ auto log_probability(Model const& m, X const& x)
 
     float_type fr = 0;
     factorize(m, x, [&](const auto& f, size_t, bool s) {
-        if (s) { fr += log2(f.factor.singletons.set.front().probability); }
+        if constexpr (is_singleton_factor<std::decay_t<decltype(f)>>)
+        {
+            fr += log2(f.probability);
+        }
+        else if (s)
+        {
+            fr += log2(f.factor.singletons.probability(0));
+        }
         else
         {
             part.clear();
@@ -57,6 +84,37 @@ auto log_probability(Model const& m, X const& x)
     return fr;
 }
 
+// overlapping factors: every factor only accounts for the part of x that it covers
+template <typename S, typename T, typename U, typename X>
+auto log_expectation(RelaxedFactorModel<S, T, U> const& m, X const& x)
+{
+    using std::log2;
+
+    T fr = 0;
+    factorize_dynamically_into_parts(m.phi, x, [&](const auto& f, size_t, bool, const auto& part) {
+        if constexpr (is_singleton_factor<std::decay_t<decltype(f)>>)
+            fr += log2(f.probability);
+        else
+            fr += log2(expectation(f.factor, part));
+    });
+    return fr;
+}
+
+template <typename S, typename T, typename U, typename X>
+auto log_probability(RelaxedFactorModel<S, T, U> const& m, X const& x)
+{
+    using std::log2;
+
+    T fr = 0;
+    factorize_dynamically_into_parts(m.phi, x, [&](const auto& f, size_t, bool, const auto& part) {
+        if constexpr (is_singleton_factor<std::decay_t<decltype(f)>>)
+            fr += log2(f.probability);
+        else
+            fr += log2(probability(f.factor, part));
+    });
+    return fr;
+}
+
 template <typename U, typename X>
 auto log_probability_of_absent_items(const std::vector<Factor<U>>& phi, const X& x)
 {
@@ -65,34 +123,30 @@ auto log_probability_of_absent_items(const std::vector<Factor<U>>& phi, const X&
     float_type p     = 0;
     for (size_t i = 0; i < phi.size(); ++i)
     {
-        const auto& e = phi[i].factor.singletons.set;
-        if (e.size() == 1 && !is_subset(e.front().element, x))
+        const auto& e = phi[i].factor.singletons;
+        if (e.size() == 1 && !is_subset(e.element(0), x))
         {
-            p += log2(1 - e.front().probability);
+            p += log2(1 - e.probability(0));
         }
     }
     return p;
 }
 
+/// the sum over all items, less the items that are present in x: O(|x|) instead of O(dim)
 template <typename U, typename X>
 auto log_probability_of_absent_items(const Factorization<U>& phi, const X& x)
 {
-    using std::log2;
-    using float_type = typename U::float_type;
-    float_type p     = 0;
-    for (size_t i = 0; i < phi.singleton_factors.size(); ++i)
-    {
-        const auto& e = phi.singleton_factors[i].factor.singletons.set;
-        if (!is_subset(e.front().element, x)) { p += log2(1 - e.front().probability); }
-    }
-    return p;
+    auto p = phi.log_absent_total;
+    foreach (x, [&](size_t i) { p += -phi.log_absent[i]; })
+        ;
+    return p.value();
 }
 
-// template <typename S, typename T, typename U, typename X>
-// auto log_probability_of_absent_items(const RelaxedFactorModel<S, T, U>& pr, const X& x)
-// {
-//     return log_probability_of_absent_items(pr.phi, x);
-// }
+template <typename S, typename T, typename U, typename X>
+auto log_probability_of_absent_items(const RelaxedFactorModel<S, T, U>& pr, const X& x)
+{
+    return log_probability_of_absent_items(pr.phi, x);
+}
 template <typename S, typename T, typename U, typename X>
 auto log_probability_of_absent_items(const StaticFactorModel<S, T, U>& pr, const X& x)
 {
@@ -131,6 +185,27 @@ auto expectation_generalized_set(Model const& m, X const& x)
     return exp2(log_expectation_generalized_set(m, x));
 }
 
+/// log_expectation of every row of a dataset, indexed by the original position of the row.
+/// only valid for the version of the distribution and the dataset it was computed for.
+template <typename T>
+struct RowScores
+{
+    RowScores()                       = default;
+    RowScores(RowScores&&)            = default;
+    RowScores& operator=(RowScores&&) = default;
+    // a copy starts empty, as the copy of FactorTables
+    RowScores(const RowScores&) {}
+    RowScores& operator=(const RowScores&) { return *this = RowScores(); }
+
+    size_t         version = 0;
+    const void*    data    = nullptr;
+    std::vector<T> scores;
+
+    bool is_valid(size_t model_version, const void* data_key, size_t n) const
+    {
+        return version == model_version && data == data_key && scores.size() == n;
+    }
+};
 
 template <typename Model>
 struct Distribution
@@ -149,7 +224,25 @@ struct Distribution
         assert(length > 0);
     }
 
-    void   clear() { model.clear(); }
+    void clear()
+    {
+        model.clear();
+        touch();
+    }
+
+    /// same as constructing a new distribution, but keeps the storage of the model
+    void reset(size_t dimension, size_t length)
+    {
+        assert(dimension > 0);
+        assert(length > 0);
+        model.init(dimension);
+        epsilon = std::min(float_type(1e-16), float_type(1) / (length + dimension));
+        touch();
+    }
+
+    /// to be called after modifying the underlying model directly
+    void touch() { version = next_model_version(); }
+
     size_t dimension() const { return model.dimension(); }
     size_t num_itemsets() const { return model.num_itemsets(); }
     size_t size() const { return model.size(); }
@@ -159,18 +252,38 @@ struct Distribution
     {
         label = std::clamp<float_type>(label, epsilon, float_type(1.0) - epsilon);
         model.insert(label, t, estimate);
+        touch();
     }
     template <typename T>
     void insert_singleton(float_type label, const T& t, bool estimate)
     {
         label = std::clamp<float_type>(label, epsilon, float_type(1.0) - epsilon);
         model.insert_singleton(label, t, estimate);
+        touch();
     }
     template <typename T>
     bool is_allowed(const T& t) const
     {
         return model.is_allowed(t);
     }
+    template <typename T>
+    void insert_deferred(float_type label, const T& t)
+    {
+        label = std::clamp<float_type>(label, epsilon, float_type(1.0) - epsilon);
+        model.insert_deferred(label, t);
+        touch();
+    }
+    template <typename T>
+    void estimate_factors_of(const T& t)
+    {
+        model.estimate_factors_of(t);
+        touch();
+    }
+    void estimate_pending()
+    {
+        model.estimate_pending();
+        touch();
+    }
     template <typename pattern_t>
     auto probability(const pattern_t& t) const
     {
@@ -202,16 +315,83 @@ struct Distribution
     {
         return disc::log_expectation_generalized_set(model, t);
     }
+
+    /// compiles the factors for log_expectation_of_row of the rows in [first, last).
+    /// not thread-safe: call it before scoring the rows in parallel, and inside a parallel
+    /// region only on a distribution that no other thread reads. compiling rows again that
+    /// are already compiled for this version only reads the tables.
+    template <typename Iter>
+    void compile_tables(Iter first, Iter last) const
+    {
+        const bool fresh = tables.version != version;
+        compile_factor_tables(model, tables, first, last, fresh);
+        if (fresh) tables.version = version;
+    }
+    template <typename Data>
+    void compile_tables(const Data& data) const
+    {
+        compile_tables(data.begin(), data.end());
+    }
+    template <typename pattern_t>
+    auto log_expectation_of_row(const pattern_t& t) const
+    {
+        if (tables.version == version) return disc::log_expectation(model, tables, t);
+        return disc::log_expectation(model, t);
+    }
+
+    /// counts the solves of the model into s; the distribution keeps s alive
+    void count_scaling_into(std::shared_ptr<ScalingStatisticsCounter> s)
+    {
+        scaling_statistics       = std::move(s);
+        model.scaling.statistics = scaling_statistics.get();
+    }
+
     underlying_model_type model;
     /// Laplacian Smoothing
     ///     makes sure that the support all distributions is the complete domain.
     ///     prevents both log p or log (1- p) from being -inf.
     float_type epsilon{1e-16};
+    size_t     version = next_model_version();
+
+    mutable FactorTables<float_type> tables;
+    mutable RowScores<float_type>    row_scores;
+
+    std::shared_ptr<ScalingStatisticsCounter> scaling_statistics;
 };
 
+/// rows per task of score_rows
+constexpr size_t row_batch_size = 256;
+
+/// writes log_expectation of every row in [first, last) to out[0, last - first). the rows are
+/// scored in parallel batches against the compiled tables of the model. both iterators have
+/// to support random access.
+template <typename M, typename Iter, typename Out>
+void score_rows(Distribution<M> const& m, Iter first, Iter last, Out out)
+{
+    using pattern_type = typename Distribution<M>::pattern_type;
+
+    m.compile_tables(first, last);
+
+    const size_t n       = last - first;
+    const size_t batches = (n + row_batch_size - 1) / row_batch_size;
+
+#pragma omp parallel for schedule(dynamic, 1)
+    for (size_t b = 0; b < batches; ++b)
+    {
+        thread_local TableScratch<pattern_type> buf;
+
+        const size_t end = std::min(n, (b + 1) * row_batch_size);
+        for (size_t k = b * row_batch_size; k < end; ++k)
+        {
+            *(out + k) = disc::log_expectation(m.model, m.tables, point(*(first + k)), buf);
+        }
+    }
+}
+
 template <typename M, typename T = typename M::float_type>
 auto estimate_model(Distribution<M>& m, IterativeScalingSettings<T> const& opts = {})
 {
+    m.touch();
     return estimate_model(m.model, opts);
 }
 
@@ -234,9 +414,19 @@ struct MaxEntDistribution : Distribution<StaticFactorModel<U, V>>
     MaxEntDistribution(size_t dimension, size_t length, const disc::Config& cfg)
         : MaxEntDistribution(dimension, length, cfg.max_factor_size, cfg.max_factor_width)
     {
+        this->model.scaling.sensitivity = cfg.scaling_sensitivity;
+        this->model.scaling.log_space   = cfg.log_space_scaling;
+    }
+
+    void reset(size_t dimension, size_t length, const disc::Config& cfg)
+    {
+        base::reset(dimension, length);
+        this->model.max_factor_size     = cfg.max_factor_size;
+        this->model.max_factor_width    = cfg.max_factor_width;
+        this->model.scaling.sensitivity = cfg.scaling_sensitivity;
+        this->model.scaling.log_space   = cfg.log_space_scaling;
     }
 };
-#if 0
 template <typename U, typename V>
 struct RelEntDistribution : Distribution<RelaxedFactorModel<U, V>>
 {
@@ -256,9 +446,19 @@ struct RelEntDistribution : Distribution<RelaxedFactorModel<U, V>>
     RelEntDistribution(size_t dimension, size_t length, const disc::Config& cfg)
         : RelEntDistribution(dimension, length, cfg.max_factor_size, cfg.max_factor_width)
     {
+        this->model.scaling.sensitivity = cfg.scaling_sensitivity;
+        this->model.scaling.log_space   = cfg.log_space_scaling;
+    }
+
+    void reset(size_t dimension, size_t length, const disc::Config& cfg)
+    {
+        base::reset(dimension, length);
+        this->model.max_factor_size     = cfg.max_factor_size;
+        this->model.max_factor_width    = cfg.max_factor_width;
+        this->model.scaling.sensitivity = cfg.scaling_sensitivity;
+        this->model.scaling.log_space   = cfg.log_space_scaling;
     }
 };
-#endif
 
 
 template <typename D>
@@ -0,0 +1,319 @@
+#pragma once
+
+#include <desc/distribution/MaxEntFactor.hxx>
+#include <desc/distribution/RelaxedFactorModel.hxx>
+#include <desc/distribution/StaticFactorModel.hxx>
+#include <desc/storage/Itemset.hxx>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace sd
+{
+namespace disc
+{
+
+/// factors up to this width get a table with 2^width entries
+constexpr size_t max_table_width = 16;
+
+/// dense log2 P(X ⊇ y) of the factors of a model, indexed by the projection y of a row onto
+/// a factor: bit b of the index stands for singletons.element(b) of the factor. an entry is
+/// compiled once for all rows that share the projection, and only valid for the version of
+/// the distribution that it was compiled for.
+template <typename T>
+struct FactorTables
+{
+    FactorTables()                          = default;
+    FactorTables(FactorTables&&)            = default;
+    FactorTables& operator=(FactorTables&&) = default;
+    // a copy starts empty: the copied distribution is about to change, and the tables of a
+    // wide model are large
+    FactorTables(const FactorTables&) {}
+    FactorTables& operator=(const FactorTables&) { return *this = FactorTables(); }
+
+    size_t version = 0;
+
+    std::vector<std::vector<T>>    tables;         // per factor, empty if it is too wide
+    std::vector<std::vector<char>> known;          // per factor, whether an entry is compiled
+    std::vector<uint32_t>          bit_of_item;    // position of the item in its factor
+    std::vector<T>                 log_singletons; // log2 p(i) of the items without a factor
+};
+
+/// per-thread buffers of log_expectation with tables
+template <typename S>
+struct TableScratch
+{
+    std::vector<size_t>   hits;
+    std::vector<uint32_t> index; // zero between rows
+    itemset<S>            part;
+};
+
+/// projects x onto the factors that it intersects: hits lists these factors in ascending
+/// order, index[j] holds the projection onto factor j and has to be reset by the caller.
+template <typename U, typename T, typename X>
+void project_onto_factors(const Factorization<U>& phi,
+                          const FactorTables<T>&  lut,
+                          const X&                x,
+                          std::vector<size_t>&    hits,
+                          std::vector<uint32_t>&  index)
+{
+    constexpr auto no_factor = Factorization<U>::no_factor;
+
+    hits.clear();
+    if (index.size() < phi.factors.size()) index.resize(phi.factors.size(), 0);
+
+    foreach (x, [&](size_t i) {
+        if (auto j = phi.item_to_factor[i]; j != no_factor)
+        {
+            if (index[j] == 0) hits.push_back(j);
+            index[j] |= uint32_t(1) << lut.bit_of_item[i];
+        }
+    })
+        ;
+
+    std::sort(hits.begin(), hits.end());
+}
+
+/// sizes the tables for the factors of phi and drops all compiled entries
+template <typename U, typename T>
+void reset_factor_tables(const Factorization<U>& phi, FactorTables<T>& lut)
+{
+    using std::log2;
+
+    lut.tables.resize(phi.factors.size());
+    lut.known.resize(phi.factors.size());
+    lut.log_singletons.resize(phi.singleton_factors.size());
+
+    for (size_t i = 0; i < phi.singleton_factors.size(); ++i)
+    {
+        lut.log_singletons[i] = log2(phi.singleton_factors[i].probability);
+    }
+    for (size_t j = 0; j < phi.factors.size(); ++j)
+    {
+        const auto w = phi.factors[j].factor.singletons.size();
+        if (w > max_table_width)
+        {
+            lut.tables[j].clear();
+            lut.known[j].clear();
+            continue;
+        }
+        lut.tables[j].resize(size_t(1) << w);
+        lut.known[j].assign(size_t(1) << w, false);
+    }
+}
+
+/// computes the entries (factor, projection) that were marked as known but not yet compiled
+template <typename U, typename T>
+void compile_pending_entries(const Factorization<U>&                        phi,
+                             FactorTables<T>&                               lut,
+                             const std::vector<std::pair<size_t, uint32_t>>& pending)
+{
+    using std::log2;
+    using S = typename U::pattern_type;
+
+    // the other threads of the loop see their own thread_local instances: share a reference
+    const auto& todo = pending;
+
+#pragma omp parallel for schedule(dynamic, 16) if (todo.size() > 64)
+    for (size_t k = 0; k < todo.size(); ++k)
+    {
+        thread_local itemset<S> part;
+
+        const auto [j, y] = todo[k];
+        const auto& f     = phi.factors[j].factor;
+
+        part.clear();
+        for (size_t b = 0; b < f.singletons.size(); ++b)
+        {
+            if (y & (uint32_t(1) << b)) part.insert(f.singletons.element(b));
+        }
+        lut.tables[j][y] = log2(expectation(f, part));
+    }
+}
+
+/// projects the part of a row that a factor covers onto the singletons of the factor
+template <typename U, typename X>
+uint32_t project_onto_factor(const U& f, const X& part)
+{
+    uint32_t y = 0;
+    for (size_t b = 0; b < f.singletons.size(); ++b)
+    {
+        if (is_subset(f.singletons.element(b), part)) y |= uint32_t(1) << b;
+    }
+    return y;
+}
+
+/// compiles the entries that the rows in [first, last) need. clears the tables if fresh.
+template <typename S, typename T, typename U, typename Iter>
+void compile_factor_tables(StaticFactorModel<S, T, U> const& m,
+                           FactorTables<T>&                  lut,
+                           Iter                              first,
+                           Iter                              last,
+                           bool                              fresh)
+{
+    using std::log2;
+
+    const auto& phi = m.phi;
+
+    if (fresh)
+    {
+        reset_factor_tables(phi, lut);
+
+        lut.bit_of_item.assign(phi.item_to_factor.size(), 0);
+        for (size_t j = 0; j < phi.factors.size(); ++j)
+        {
+            const auto& f = phi.factors[j].factor;
+            if (lut.tables[j].empty()) continue;
+            for (size_t b = 0; b < f.singletons.size(); ++b)
+                lut.bit_of_item[f.singletons.element(b)] = b;
+        }
+    }
+
+    thread_local std::vector<size_t>                      hits;
+    thread_local std::vector<uint32_t>                    index;
+    thread_local std::vector<std::pair<size_t, uint32_t>> pending;
+
+    pending.clear();
+    for (auto it = first; it != last; ++it)
+    {
+        project_onto_factors(phi, lut, point(*it), hits, index);
+        for (auto j : hits)
+        {
+            if (!lut.tables[j].empty() && !lut.known[j][index[j]])
+            {
+                lut.known[j][index[j]] = true;
+                pending.emplace_back(j, index[j]);
+            }
+            index[j] = 0;
+        }
+    }
+
+    compile_pending_entries(phi, lut, pending);
+}
+
+/// the factors of the relaxed model overlap: an entry is keyed by the part of a row that the
+/// cover assigns to the factor, which the same cover reproduces when scoring.
+template <typename S, typename T, typename U, typename Iter>
+void compile_factor_tables(RelaxedFactorModel<S, T, U> const& m,
+                           FactorTables<T>&                   lut,
+                           Iter                               first,
+                           Iter                               last,
+                           bool                               fresh)
+{
+    const auto& phi = m.phi;
+
+    if (fresh) reset_factor_tables(phi, lut);
+
+    thread_local std::vector<std::pair<size_t, uint32_t>> pending;
+
+    pending.clear();
+    for (auto it = first; it != last; ++it)
+    {
+        factorize_dynamically_into_parts(
+            phi, point(*it), [&](const auto& f, size_t j, bool, const auto& part) {
+                if constexpr (!is_singleton_factor<std::decay_t<decltype(f)>>)
+                {
+                    if (lut.tables[j].empty()) return;
+                    const auto y = project_onto_factor(f.factor, part);
+                    if (!lut.known[j][y])
+                    {
+                        lut.known[j][y] = true;
+                        pending.emplace_back(j, y);
+                    }
+                }
+            });
+    }
+
+    compile_pending_entries(phi, lut, pending);
+}
+
+/// models that cannot be compiled are scored as they are
+template <typename Model, typename T, typename Iter>
+void compile_factor_tables(Model const&, FactorTables<T>&, Iter, Iter, bool)
+{
+}
+
+/// same as log_expectation(m, x), but looks the factors of x up in the compiled tables
+template <typename S, typename T, typename U, typename X>
+auto log_expectation(StaticFactorModel<S, T, U> const& m,
+                     FactorTables<T> const&            lut,
+                     X const&                          x,
+                     TableScratch<S>&                  buf)
+{
+    using std::log2;
+
+    constexpr auto no_factor = Factorization<U>::no_factor;
+
+    const auto& phi = m.phi;
+
+    project_onto_factors(phi, lut, x, buf.hits, buf.index);
+
+    // same order of summation as log_expectation(m, x)
+    T fr = 0;
+    for (auto j : buf.hits)
+    {
+        const auto y = buf.index[j];
+        if (!lut.tables[j].empty() && lut.known[j][y]) { fr += lut.tables[j][y]; }
+        else
+        {
+            buf.part.clear();
+            intersection(x, phi.factors[j].range, buf.part);
+            fr += log2(expectation(phi.factors[j].factor, buf.part));
+        }
+        buf.index[j] = 0;
+    }
+
+    foreach (x, [&](size_t i) {
+        if (phi.item_to_factor[i] == no_factor) fr += lut.log_singletons[i];
+    })
+        ;
+    return fr;
+}
+
+template <typename S, typename T, typename U, typename X>
+auto log_expectation(RelaxedFactorModel<S, T, U> const& m,
+                     FactorTables<T> const&             lut,
+                     X const&                           x,
+                     TableScratch<S>&)
+{
+    using std::log2;
+
+    // same cover and order of summation as log_expectation(m, x)
+    T fr = 0;
+    factorize_dynamically_into_parts(m.phi, x, [&](const auto& f, size_t j, bool, const auto& part) {
+        if constexpr (is_singleton_factor<std::decay_t<decltype(f)>>)
+        {
+            fr += lut.log_singletons[j];
+        }
+        else
+        {
+            // wide factors have no table, and their projection would not fit into an index
+            const bool compiled = !lut.tables[j].empty();
+            const auto y        = compiled ? project_onto_factor(f.factor, part) : 0;
+            if (compiled && lut.known[j][y])
+                fr += lut.tables[j][y];
+            else
+                fr += log2(expectation(f.factor, part));
+        }
+    });
+    return fr;
+}
+
+template <typename Model, typename T, typename X, typename S>
+auto log_expectation(Model const& m, FactorTables<T> const&, X const& x, TableScratch<S>&)
+{
+    return log_expectation(m, x);
+}
+
+template <typename Model, typename T, typename X>
+auto log_expectation(Model const& m, FactorTables<T> const& lut, X const& x)
+{
+    thread_local TableScratch<typename Model::pattern_type> buf;
+    return log_expectation(m, lut, x, buf);
+}
+
+} // namespace disc
+} // namespace sd
@@ -2,7 +2,11 @@
 
 #include <desc/distribution/MaxEntFactor.hxx>
 
+#include <atomic>
+#include <chrono>
+#include <limits>
 #include <cmath>
+#include <optional>
 #include <vector>
 
 namespace sd
@@ -10,17 +14,111 @@ namespace sd
 namespace disc
 {
 
+enum class ScalingSolver
+{
+    automatic,
+    iterative_scaling,
+    newton
+};
+
+struct IterativeScalingStatistics
+{
+    size_t calls           = 0; // solves of a factor
+    size_t iterations      = 0; // passes over the block tables
+    size_t capped          = 0; // solves that stopped at max_iteration
+    size_t skipped_updates = 0; // coefficient updates rejected by bad_scaling_factor
+    size_t skipped_solves  = 0; // insertions whose constraint already held
+    double residual        = 0; // sum of final residuals
+    double seconds         = 0; // wall time spent solving
+
+    IterativeScalingStatistics& operator+=(const IterativeScalingStatistics& o)
+    {
+        calls += o.calls;
+        iterations += o.iterations;
+        capped += o.capped;
+        skipped_updates += o.skipped_updates;
+        skipped_solves += o.skipped_solves;
+        residual += o.residual;
+        seconds += o.seconds;
+        return *this;
+    }
+
+    friend IterativeScalingStatistics operator-(IterativeScalingStatistics a,
+                                                const IterativeScalingStatistics& b)
+    {
+        a.calls -= b.calls;
+        a.iterations -= b.iterations;
+        a.capped -= b.capped;
+        a.skipped_updates -= b.skipped_updates;
+        a.skipped_solves -= b.skipped_solves;
+        a.residual -= b.residual;
+        a.seconds -= b.seconds;
+        return a;
+    }
+};
+
+/// totals of the solves of all models that count into it. those models can be solved in
+/// parallel, hence the atomics.
+struct ScalingStatisticsCounter
+{
+    std::atomic<size_t> calls{0};
+    std::atomic<size_t> iterations{0};
+    std::atomic<size_t> capped{0};
+    std::atomic<size_t> skipped_updates{0};
+    std::atomic<size_t> skipped_solves{0};
+    std::atomic<double> residual{0};
+    std::atomic<double> seconds{0};
+
+    void add(const IterativeScalingStatistics& s)
+    {
+        const auto add_to = [](std::atomic<double>& a, double v) {
+            double old = a.load(std::memory_order_relaxed);
+            while (!a.compare_exchange_weak(old, old + v, std::memory_order_relaxed))
+                ;
+        };
+        calls.fetch_add(s.calls, std::memory_order_relaxed);
+        iterations.fetch_add(s.iterations, std::memory_order_relaxed);
+        capped.fetch_add(s.capped, std::memory_order_relaxed);
+        skipped_updates.fetch_add(s.skipped_updates, std::memory_order_relaxed);
+        skipped_solves.fetch_add(s.skipped_solves, std::memory_order_relaxed);
+        add_to(residual, s.residual);
+        add_to(seconds, s.seconds);
+    }
+
+    IterativeScalingStatistics load() const
+    {
+        IterativeScalingStatistics s;
+        s.calls           = calls.load(std::memory_order_relaxed);
+        s.iterations      = iterations.load(std::memory_order_relaxed);
+        s.capped          = capped.load(std::memory_order_relaxed);
+        s.skipped_updates = skipped_updates.load(std::memory_order_relaxed);
+        s.skipped_solves  = skipped_solves.load(std::memory_order_relaxed);
+        s.residual        = residual.load(std::memory_order_relaxed);
+        s.seconds         = seconds.load(std::memory_order_relaxed);
+        return s;
+    }
+};
+
 template <typename float_type>
 struct IterativeScalingSettings
 {
-    float_type sensitivity   = 1e-8;
-    float_type epsilon       = 1e-10;
-    size_t     max_iteration = 100;
-    bool       warmstart     = false;
+    float_type    sensitivity   = 1e-8;
+    float_type    epsilon       = 1e-10;
+    size_t        max_iteration = 100;
+    bool          warmstart     = false;
+    ScalingSolver solver        = ScalingSolver::automatic;
+    // automatic: use newton for factors with at least this many itemsets. goes by size
+    // alone; probing how fast iterative scaling contracts the residual, as a measure of
+    // conditioning, cost more passes than it saved even on the smallest factors
+    size_t newton_min_itemsets = 2;
+    // evaluate block probabilities in log-space; keeps double stable where products of
+    // coefficients would under- or overflow
+    bool log_space = false;
+    // receives the statistics of every solve, if set
+    ScalingStatisticsCounter* statistics = nullptr;
     // bool       normalize     = false;
 };
 
-
 template <typename T>
 bool bad_scaling_factor(const T& r)
 {
@@ -49,19 +147,35 @@ void reset_normalizer(MaxEntFactor<U, V>& model)
 template <typename U, typename V>
 void reset_coefficients(MaxEntFactor<U, V>& model)
 {
-    for (auto& x : model.itemsets.set) x.theta = x.frequency;
-    for (auto& x : model.singletons.set) x.theta = x.frequency;
+    model.itemsets.thetas   = model.itemsets.frequencies;
+    model.singletons.thetas = model.singletons.frequencies;
     reset_normalizer(model);
 }
 
+template <typename U, typename V>
+void estimate_singletons(MaxEntFactor<U, V>& model)
+{
+    // without itemsets all items are independent: p_i = theta_i / 2, hence theta_i = 2 q_i
+    reset_normalizer(model);
+    auto& s = model.singletons;
+    for (size_t i = 0; i < s.size(); ++i)
+    {
+        s.thetas[i]        = 2 * s.frequencies[i];
+        s.probabilities[i] = s.frequencies[i];
+    }
+}
+
 template <typename Model, typename Transactions, typename AllTransactions, typename F>
 auto iterative_scaling(Model&                           model,
                        const std::vector<Transactions>& transactions,
                        const AllTransactions&,
-                       IterativeScalingSettings<F> opts)
+                       IterativeScalingSettings<F> opts,
+                       IterativeScalingStatistics* stats = nullptr)
 {
     using float_type = typename Model::float_type;
-    using std::abs;
+    using std::abs, std::exp, std::log;
+
+    IterativeScalingStatistics local;
 
     if (!opts.warmstart) { reset_coefficients(model); }
     else
@@ -71,38 +185,278 @@ auto iterative_scaling(Model&                           model,
 
     float_type pg = std::numeric_limits<float_type>::max();
 
+    local.capped = 1;
     for (size_t it = 0; it < opts.max_iteration; ++it)
     {
         float_type g = 0;
+        ++local.iterations;
 
         for (size_t i = 0; i < model.size(); ++i)
         {
-            auto q               = model.frequency(i);
-            auto p               = expectation_known(transactions[i], model, model.point(i));
+            float_type q = model.frequency(i);
+            float_type p, r;
+            if (opts.log_space)
+            {
+                auto lp = log_expectation_known(transactions[i], model, model.point(i));
+                p       = exp(lp);
+                r       = exp(log(q) - lp);
+            }
+            else
+            {
+                p = expectation_known(transactions[i], model, model.point(i));
+                r = q / p;
+            }
             model.probability(i) = p;
 
             g += abs(q - p);
 
             if (abs(q - p) < opts.sensitivity) continue;
-            if(bad_scaling_factor(model.coefficient(i) * (q / p))) continue;
+            if (bad_scaling_factor(model.coefficient(i) * r))
+            {
+                ++local.skipped_updates;
+                continue;
+            }
             // if (bad_scaling_factor(p, q, model.coefficient(i))) continue;
             // if (bad_condition_number(p, q, model.normalizer())) continue;
 
-            model.coefficient(i) *= q / p; // * ((1 - p) / (1 - q));
+            model.coefficient(i) *= r; // * ((1 - p) / (1 - q));
             // model.normalizer() *= (1 - q) / (1 - p);
         }
 
         if (g / float_type(model.size()) < opts.sensitivity || abs(g - pg) < opts.epsilon)
         {
-            pg = g;
+            pg           = g;
+            local.capped = 0;
             break;
         }
 
         pg = g;
     }
+    if (stats) *stats += local;
     return pg;
 }
 
+template <typename T>
+bool solve_linear_system(std::vector<T>& a, std::vector<T>& b, size_t n)
+{
+    using std::abs;
+    for (size_t c = 0; c < n; ++c)
+    {
+        size_t pivot = c;
+        for (size_t r = c + 1; r < n; ++r)
+            if (abs(a[r * n + c]) > abs(a[pivot * n + c])) pivot = r;
+
+        if (!(abs(a[pivot * n + c]) > T(1e-12))) return false;
+
+        if (pivot != c)
+        {
+            for (size_t k = 0; k < n; ++k) std::swap(a[c * n + k], a[pivot * n + k]);
+            std::swap(b[c], b[pivot]);
+        }
+        for (size_t r = c + 1; r < n; ++r)
+        {
+            const T f = a[r * n + c] / a[c * n + c];
+            if (f == 0) continue;
+            for (size_t k = c; k < n; ++k) a[r * n + k] -= f * a[c * n + k];
+            b[r] -= f * b[c];
+        }
+    }
+    for (size_t c = n; c-- > 0;)
+    {
+        for (size_t k = c + 1; k < n; ++k) b[c] -= a[c * n + k] * b[k];
+        b[c] /= a[c * n + c];
+    }
+    return true;
+}
+
+/// Newton's method on the moment conditions log p_i(lambda) = log q_i, lambda = log theta.
+/// Iterative scaling is the same fixed point iteration using only the diagonal of the
+/// Jacobian; using all of it converges quadratically on strongly correlated factors.
+/// Returns nullopt if a step fails, leaving the model at the last accepted iterate.
+template <typename U, typename V, typename Transactions, typename F>
+std::optional<V> newton_scaling(MaxEntFactor<U, V>&              model,
+                                const std::vector<Transactions>& transactions,
+                                IterativeScalingSettings<F>      opts,
+                                IterativeScalingStatistics*      stats = nullptr)
+{
+    using std::abs, std::exp, std::log;
+
+    const size_t n  = model.size();
+    const size_t ns = model.singletons.size();
+
+    thread_local std::vector<V>      jacobian, residual, theta, step, weights;
+    thread_local std::vector<size_t> covered, offsets;
+
+    const auto contains = [&](size_t k, const auto& b) {
+        if (k < ns)
+        {
+            const auto e = model.singletons.element(k);
+            return is_subset(e, signature(e), b.cover, b.signature);
+        }
+        return is_subset(
+            model.itemsets.point(k - ns), model.itemsets.signatures[k - ns], b.cover, b.signature);
+    };
+
+    IterativeScalingStatistics local;
+
+    const auto evaluate = [&](bool with_jacobian) {
+        ++local.iterations;
+        if (with_jacobian) jacobian.assign(n * n, V(0));
+        residual.resize(n);
+
+        V g = 0;
+        for (size_t i = 0; i < n; ++i)
+        {
+            V p = 0, lp = 0;
+            if (opts.log_space)
+            {
+                // log-weights of all blocks first, then J_ik = sum_b w_b / p = exp(lw_b - lp)
+                LogSumExp<V> acc;
+                covered.clear();
+                weights.clear();
+                offsets.assign(1, 0);
+                const V lz = log(model.singletons.theta0) + log(model.itemsets.theta0);
+                for (const auto& b : transactions[i])
+                {
+                    V lw = log(V(b.value)) + lz;
+                    for (size_t k = 0; k < n; ++k)
+                    {
+                        if (contains(k, b))
+                        {
+                            lw += log(model.coefficient(k));
+                            covered.push_back(k);
+                        }
+                    }
+                    acc += lw;
+                    weights.push_back(lw);
+                    offsets.push_back(covered.size());
+                }
+                lp = acc.value();
+                p  = exp(lp);
+                if (with_jacobian && lp > -std::numeric_limits<V>::infinity())
+                    for (size_t j = 0; j < weights.size(); ++j)
+                    {
+                        const V r = exp(weights[j] - lp);
+                        for (size_t o = offsets[j]; o < offsets[j + 1]; ++o)
+                            jacobian[i * n + covered[o]] += r;
+                    }
+            }
+            else
+            {
+                for (const auto& b : transactions[i])
+                {
+                    covered.clear();
+                    V w = b.value * model.singletons.theta0 * model.itemsets.theta0;
+                    for (size_t k = 0; k < n; ++k)
+                    {
+                        if (contains(k, b))
+                        {
+                            w *= model.coefficient(k);
+                            covered.push_back(k);
+                        }
+                    }
+                    p += w;
+                    if (with_jacobian)
+                        for (auto k : covered) jacobian[i * n + k] += w;
+                }
+                lp = log(p);
+            }
+
+            const auto q         = model.frequency(i);
+            model.probability(i) = p;
+            g += abs(q - p);
+
+            const bool matchable = opts.log_space ? lp > -std::numeric_limits<V>::infinity() : p > 0;
+            if (q <= 0 || !matchable || bad_scaling_factor(model.coefficient(i)))
+            {
+                // cannot be matched in log-space: keep its coefficient fixed
+                if (with_jacobian)
+                {
+                    std::fill_n(jacobian.begin() + i * n, n, V(0));
+                    jacobian[i * n + i] = 1;
+                }
+                residual[i] = 0;
+                continue;
+            }
+            residual[i] = log(q) - lp;
+            if (with_jacobian && !opts.log_space)
+                for (size_t k = 0; k < n; ++k) jacobian[i * n + k] /= p;
+        }
+        return g;
+    };
+
+    const auto finish = [&](std::optional<V> result) {
+        if (stats) *stats += local;
+        return result;
+    };
+
+    V g = evaluate(true);
+
+    local.capped = 1;
+    for (size_t it = 0; it < opts.max_iteration; ++it)
+    {
+        if (g / V(n) < opts.sensitivity)
+        {
+            local.capped = 0;
+            break;
+        }
+
+        if (!solve_linear_system(jacobian, residual, n)) return finish(std::nullopt);
+
+        theta.resize(n);
+        step.resize(n);
+        for (size_t k = 0; k < n; ++k)
+        {
+            theta[k] = model.coefficient(k);
+            step[k]  = residual[k];
+        }
+
+        // backtracking; the trial point is evaluated with its jacobian for the next step
+        bool accepted = false;
+        V    next     = g;
+        for (V alpha = 1; alpha > V(1e-3); alpha /= 2)
+        {
+            for (size_t k = 0; k < n; ++k)
+                model.coefficient(k) = theta[k] * exp(alpha * step[k]);
+
+            next = evaluate(true);
+            if (next < g || next / V(n) < opts.sensitivity)
+            {
+                accepted = true;
+                break;
+            }
+        }
+
+        if (!accepted)
+        {
+            for (size_t k = 0; k < n; ++k) model.coefficient(k) = theta[k];
+            evaluate(false);
+            local.capped = 0;
+            return finish(std::nullopt);
+        }
+
+        const bool stalled = abs(g - next) < opts.epsilon;
+        g                  = next;
+        if (stalled || g / V(n) < opts.sensitivity)
+        {
+            local.capped = 0;
+            break;
+        }
+    }
+    return finish(g);
+}
+
+template <typename U, typename V, typename F>
+bool use_newton_scaling(MaxEntFactor<U, V> const& m, IterativeScalingSettings<F> const& opts)
+{
+    switch (opts.solver)
+    {
+    case ScalingSolver::newton: return true;
+    case ScalingSolver::iterative_scaling: return false;
+    default: return m.itemsets.size() >= opts.newton_min_itemsets;
+    }
+}
+
 template <typename S, typename T, typename U = double>
 auto estimate_model(MaxEntFactor<S, T>& m, IterativeScalingSettings<U> const& opts = {})
 {
@@ -115,10 +469,21 @@ auto estimate_model(MaxEntFactor<S, T>& m, IterativeScalingSettings<U> const& op
     thread_local std::vector<std::vector<block_t>> t;
     thread_local std::vector<block_t>              partitions;
 
-    m.itemsets.num_singletons = m.singletons.set.size();
+    m.itemsets.num_singletons = m.singletons.size();
+
+    m.estimated = true;
+
+    if (m.itemsets.empty())
+    {
+        estimate_singletons(m);
+        return float_type(0);
+    }
+
+    using clock      = std::chrono::steady_clock;
+    const auto start = clock::now();
 
     // this covers an edge case that usually never happens.
-    const bool use_one_set = false && m.singletons.set.size() < m.itemsets.set.size();
+    const bool use_one_set = false && m.singletons.size() < m.itemsets.size();
     if (use_one_set)
     {
         auto n = compute_counts(m.itemsets.num_singletons, m.singletons, partitions);
@@ -149,18 +514,89 @@ auto estimate_model(MaxEntFactor<S, T>& m, IterativeScalingSettings<U> const& op
             t[i].resize(n);
         }
 
-        auto it = std::remove_if(t[i].begin(), t[i].end(), [&](const auto& x) {
-            return x.value == 0 || !is_subset(m.point(i), x.cover);
+        const auto sx = signature(m.point(i));
+        auto       it = std::remove_if(t[i].begin(), t[i].end(), [&](const auto& x) {
+            return x.value == 0 || !is_subset(m.point(i), sx, x.cover, x.signature);
         });
         t[i].erase(it, t[i].end());
     }
 
-    const auto g = iterative_scaling(m, t, partitions, opts);
+    IterativeScalingStatistics stats;
+    stats.calls = 1;
+
+    float_type g = 0;
+    if (use_newton_scaling(m, opts))
+    {
+        auto newton_opts = opts;
+        if (!opts.warmstart) reset_coefficients(m);
+        else
+            reset_normalizer(m);
+        if (auto r = newton_scaling(m, t, newton_opts, &stats); r) { g = *r; }
+        else
+        {
+            // fall back to the multiplicative updates from wherever newton stopped
+            newton_opts.warmstart = true;
+            g = iterative_scaling(m, t, partitions, newton_opts, &stats);
+        }
+    }
+    else
+    {
+        g = iterative_scaling(m, t, partitions, opts, &stats);
+    }
 
-    // update_precomputed_probabilities(m, t);
+    stats.residual = static_cast<double>(g);
+    stats.seconds  = std::chrono::duration<double>(clock::now() - start).count();
+    if (opts.statistics) opts.statistics->add(stats);
 
     return g;
 }
 
+/// inserts t without solving; the factor stays estimated if its current solution already
+/// satisfies the new constraint. returns whether the factor is still estimated.
+template <typename S, typename T, typename P, typename F>
+bool insert_deferred(MaxEntFactor<S, T>&                m,
+                     T                                  label,
+                     const P&                           t,
+                     IterativeScalingSettings<F> const& opts)
+{
+    using std::abs;
+
+    if (opts.warmstart && m.estimated && !is_singleton(t) && !contains_pattern(m, t))
+    {
+        // the new coefficient starts at 1 and leaves the current solution untouched:
+        // if that solution already satisfies the new constraint, there is nothing to solve.
+        thread_local itemset<S> x;
+        x.assign(t);
+        reset_normalizer(m);
+        const auto p = expectation_unknown(m, x);
+
+        m.insert_pattern(label, t, false);
+        m.itemsets.probability(m.itemsets.find(x)) = p;
+        m.estimated                                = abs(label - p) < opts.sensitivity;
+        if (m.estimated && opts.statistics)
+        {
+            IterativeScalingStatistics stats;
+            stats.skipped_solves = 1;
+            opts.statistics->add(stats);
+        }
+    }
+    else
+    {
+        m.insert(label, t, false);
+    }
+    return m.estimated;
+}
+
+template <typename S, typename T, typename P, typename F>
+void insert_and_estimate(MaxEntFactor<S, T>&         m,
+                         T                           label,
+                         const P&                    t,
+                         IterativeScalingSettings<F> opts)
+{
+    opts.warmstart = opts.warmstart && m.estimated;
+
+    if (!insert_deferred(m, label, t, opts)) { estimate_model(m, opts); }
+}
+
 } // namespace disc
 } // namespace sd
@@ -3,8 +3,11 @@
 #include <desc/distribution/Transactions.hxx>
 #include <desc/storage/Dataset.hxx>
 #include <desc/storage/Itemset.hxx>
+#include <math/Summation.hxx>
 
+#include <algorithm>
 #include <cstddef>
+#include <limits>
 #include <numeric>
 #include <optional>
 #include <vector>
@@ -14,6 +17,17 @@ namespace sd
 namespace disc
 {
 
+template <typename T>
+std::size_t fingerprint(const T& x)
+{
+    std::size_t h = 0xcbf29ce484222325;
+    foreach (x, [&](std::size_t i) {
+        h ^= i + 0x9e3779b97f4a7c15 + (h << 6) + (h >> 2);
+    })
+        ;
+    return h;
+}
+
 template <typename U, typename V>
 struct SingletonModel
 {
@@ -22,130 +36,209 @@ struct SingletonModel
 
     using index_type = std::size_t;
 
-    struct singleton_storage
-    {
-        index_type element;
-        float_type frequency;
-        float_type theta       = 1;
-        float_type probability = 0.5;
-    };
-
-    std::vector<singleton_storage> set;
-    mutable itemset<U>             buffer;
+    std::vector<index_type> elements;
+    std::vector<float_type> frequencies;
+    std::vector<float_type> thetas;
+    std::vector<float_type> probabilities;
+    mutable itemset<U>      buffer;
 
     float_type theta0 = 1;
     size_t     dim    = 0;
 
-    auto&       coefficient(size_t i) { return set[i].theta; }
+    auto&       coefficient(size_t i) { return thetas[i]; }
     auto&       normalizer() { return theta0; }
     const auto& normalizer() const { return theta0; }
-    auto&       probability(size_t i) { return set[i].probability; }
-    const auto& frequency(size_t i) const { return set[i].frequency; }
-    const auto& probability(size_t i) const { return set[i].probability; }
-    const auto& coefficient(size_t i) const { return set[i].theta; }
+    auto&       probability(size_t i) { return probabilities[i]; }
+    const auto& frequency(size_t i) const { return frequencies[i]; }
+    const auto& probability(size_t i) const { return probabilities[i]; }
+    const auto& coefficient(size_t i) const { return thetas[i]; }
+    index_type  element(size_t i) const { return elements[i]; }
     const auto& point(size_t i) const
     {
         buffer.clear();
-        buffer.insert(set[i].element);
+        buffer.insert(elements[i]);
         return buffer;
     }
 
+    /// a linear scan: a factor holds at most Config::max_factor_width singletons
+    size_t find(index_type element) const
+    {
+        return std::distance(elements.begin(),
+                             std::find(elements.begin(), elements.end(), element));
+    }
+
+    void push_back(float_type label,
+                   index_type element,
+                   float_type theta       = 1,
+                   float_type probability = 0.5)
+    {
+        elements.push_back(element);
+        frequencies.push_back(label);
+        thetas.push_back(theta);
+        probabilities.push_back(probability);
+    }
+
     void insert(float_type label, index_type element)
     {
-        auto it = std::find_if(
-            set.begin(), set.end(), [element](const auto& i) { return i.element == element; });
-        if (it != set.end()) { it->frequency = label; }
+        if (auto i = find(element); i < size()) { frequencies[i] = label; }
         else
         {
-            set.push_back({element, label});
+            push_back(label, element);
         }
     }
 
     template <typename T>
     void insert(float_type label, const T& t)
     {
-        set.push_back({static_cast<index_type>(front(t)), label});
+        push_back(label, static_cast<index_type>(front(t)));
+    }
+
+    void append(const SingletonModel& other)
+    {
+        elements.insert(elements.end(), other.elements.begin(), other.elements.end());
+        frequencies.insert(frequencies.end(), other.frequencies.begin(), other.frequencies.end());
+        thetas.insert(thetas.end(), other.thetas.begin(), other.thetas.end());
+        probabilities.insert(
+            probabilities.end(), other.probabilities.begin(), other.probabilities.end());
+    }
+
+    void erase(size_t i)
+    {
+        elements.erase(elements.begin() + i);
+        frequencies.erase(frequencies.begin() + i);
+        thetas.erase(thetas.begin() + i);
+        probabilities.erase(probabilities.begin() + i);
+    }
+
+    void clear()
+    {
+        elements.clear();
+        frequencies.clear();
+        thetas.clear();
+        probabilities.clear();
     }
 
     size_t dimension() const { return dim; }
-    size_t size() const { return set.size(); }
+    size_t size() const { return elements.size(); }
+    bool   empty() const { return elements.empty(); }
 
     template <typename Pattern_Type>
     std::optional<float_type> get_precomputed_expectation(const Pattern_Type& x) const
     {
-        auto element = front(x);
-        auto it      = std::find_if(
-            begin(set), end(set), [element](const auto& s) { return s.element == element; });
-        if (it != end(set)) { return {it->probability}; }
+        if (auto i = find(front(x)); i < size()) { return {probabilities[i]}; }
         else
             return std::nullopt;
     }
 };
 
-template <typename U, typename V>
-struct ItemsetStorage
-{
-    using float_type = V;
-
-    itemset<U> point{};
-    float_type frequency   = 0;
-    float_type theta       = 1;
-    float_type probability = 0.5;
-};
-
 template <typename U, typename V>
 struct ItemsetModel
 {
     using float_type   = V;
     using pattern_type = U;
 
-    using itemset_storage = ItemsetStorage<U, V>;
-
-    std::vector<itemset_storage> set;
+    std::vector<itemset<U>>     points;
+    std::vector<std::size_t>    fingerprints;
+    std::vector<signature_type> signatures;
+    std::vector<float_type>     frequencies;
+    std::vector<float_type>     thetas;
+    std::vector<float_type>     probabilities;
 
     float_type       theta0         = 1;
     size_t           dim            = 0;
     size_t           num_singletons = 1;
     disc::itemset<U> buffer;
 
+    /// a linear scan over the fingerprint column: a factor holds at most
+    /// Config::max_factor_size itemsets, for which a hash index costs more than it saves.
+    template <typename T>
+    size_t find(const T& t, std::size_t h) const
+    {
+        for (size_t i = 0; i < fingerprints.size(); ++i)
+        {
+            if (fingerprints[i] == h && equal(points[i], t)) return i;
+        }
+        return size();
+    }
+
+    template <typename T>
+    size_t find(const T& t) const
+    {
+        return find(t, fingerprint(t));
+    }
+
     template <typename T>
     void insert(float_type label, const T& t)
     {
         buffer.assign(t);
-        auto it = std::find_if(
-            set.begin(), set.end(), [&](const auto& i) { return equal(i.point, buffer); });
-        if (it != set.end()) { it->frequency = label; }
+        const auto h = fingerprint(buffer);
+        if (auto i = find(buffer, h); i < size()) { frequencies[i] = label; }
         else
         {
-            set.push_back({buffer, label, 1});
+            points.push_back(buffer);
+            fingerprints.push_back(h);
+            signatures.push_back(signature(buffer));
+            frequencies.push_back(label);
+            thetas.push_back(1);
+            probabilities.push_back(0.5);
             // update_partitions();
         }
     }
 
     // void update_partitions() { compute_counts(width(), *this, partitions); }
 
+    void append(const ItemsetModel& other)
+    {
+        points.insert(points.end(), other.points.begin(), other.points.end());
+        fingerprints.insert(
+            fingerprints.end(), other.fingerprints.begin(), other.fingerprints.end());
+        signatures.insert(signatures.end(), other.signatures.begin(), other.signatures.end());
+        frequencies.insert(frequencies.end(), other.frequencies.begin(), other.frequencies.end());
+        thetas.insert(thetas.end(), other.thetas.begin(), other.thetas.end());
+        probabilities.insert(
+            probabilities.end(), other.probabilities.begin(), other.probabilities.end());
+    }
+
+    void erase(size_t i)
+    {
+        points.erase(points.begin() + i);
+        fingerprints.erase(fingerprints.begin() + i);
+        signatures.erase(signatures.begin() + i);
+        frequencies.erase(frequencies.begin() + i);
+        thetas.erase(thetas.begin() + i);
+        probabilities.erase(probabilities.begin() + i);
+    }
+
+    void clear()
+    {
+        points.clear();
+        fingerprints.clear();
+        signatures.clear();
+        frequencies.clear();
+        thetas.clear();
+        probabilities.clear();
+    }
+
     size_t width() const { return num_singletons; }
     size_t dimension() const { return dim; }
-    size_t size() const { return set.size(); }
+    size_t size() const { return points.size(); }
 
-    auto&       coefficient(size_t i) { return set[i].theta; }
+    auto&       coefficient(size_t i) { return thetas[i]; }
     auto&       normalizer() { return theta0; }
     const auto& normalizer() const { return theta0; }
-    auto&       probability(size_t i) { return set[i].probability; }
-    const auto& frequency(size_t i) const { return set[i].frequency; }
-    const auto& probability(size_t i) const { return set[i].probability; }
-    const auto& point(size_t i) const { return set[i].point; }
-    const auto& coefficient(size_t i) const { return set[i].theta; }
+    auto&       probability(size_t i) { return probabilities[i]; }
+    const auto& frequency(size_t i) const { return frequencies[i]; }
+    const auto& probability(size_t i) const { return probabilities[i]; }
+    const auto& point(size_t i) const { return points[i]; }
+    const auto& coefficient(size_t i) const { return thetas[i]; }
 
     decltype(auto) operator[](size_t i) const { return point(i); }
-    bool           empty() const { return set.empty(); }
+    bool           empty() const { return points.empty(); }
 
     template <typename Pattern_Type>
     std::optional<float_type> get_precomputed_expectation(const Pattern_Type& x) const
     {
-        const auto it = std::find_if(
-            set.begin(), set.end(), [&](const auto& s) { return equal(s.point, x); });
-        if (it != set.end()) { return {it->probability}; }
+        if (auto i = find(x); i < size()) { return {probabilities[i]}; }
         else
             return std::nullopt;
     }
@@ -159,6 +252,8 @@ struct MaxEntFactor
 
     SingletonModel<U, V> singletons;
     ItemsetModel<U, V>   itemsets;
+    // coefficients solve all constraints; cleared when a constraint is inserted unestimated
+    bool estimated = true;
 
     explicit MaxEntFactor(size_t w = 0)
     {
@@ -167,40 +262,53 @@ struct MaxEntFactor
         itemsets.num_singletons = 1;
     }
 
+    /// empties the factor for width w, keeping the allocated columns.
+    void reset(size_t w)
+    {
+        singletons.clear();
+        itemsets.clear();
+        singletons.theta0       = 1;
+        itemsets.theta0         = 1;
+        singletons.dim          = w;
+        itemsets.dim            = w;
+        itemsets.num_singletons = 1;
+        estimated               = true;
+    }
+
     auto& coefficient(size_t i) const
     {
-        return i < singletons.set.size() ? singletons.coefficient(i)
-                                         : itemsets.coefficient(i - singletons.set.size());
+        return i < singletons.size() ? singletons.coefficient(i)
+                                     : itemsets.coefficient(i - singletons.size());
     }
     auto& coefficient(size_t i)
     {
-        return i < singletons.set.size() ? singletons.coefficient(i)
-                                         : itemsets.coefficient(i - singletons.set.size());
+        return i < singletons.size() ? singletons.coefficient(i)
+                                     : itemsets.coefficient(i - singletons.size());
     }
     auto&       normalizer() { return itemsets.normalizer(); }
     const auto& normalizer() const { return itemsets.normalizer(); }
     auto        frequency(size_t i) const
     {
-        return i < singletons.set.size() ? singletons.frequency(i)
-                                         : itemsets.frequency(i - singletons.set.size());
+        return i < singletons.size() ? singletons.frequency(i)
+                                     : itemsets.frequency(i - singletons.size());
     }
     auto& probability(size_t i)
     {
-        return i < singletons.set.size() ? singletons.probability(i)
-                                         : itemsets.probability(i - singletons.set.size());
+        return i < singletons.size() ? singletons.probability(i)
+                                     : itemsets.probability(i - singletons.size());
     }
     auto& probability(size_t i) const
     {
-        return i < singletons.set.size() ? singletons.probability(i)
-                                         : itemsets.probability(i - singletons.set.size());
+        return i < singletons.size() ? singletons.probability(i)
+                                     : itemsets.probability(i - singletons.size());
     }
     const auto& point(size_t i)
     {
-        return i < singletons.set.size() ? singletons.point(i)
-                                         : itemsets.point(i - singletons.set.size());
+        return i < singletons.size() ? singletons.point(i)
+                                     : itemsets.point(i - singletons.size());
     }
-    bool   is_pattern_known(size_t i) const { return i >= singletons.set.size(); }
-    size_t size() const { return singletons.set.size() + itemsets.set.size(); }
+    bool   is_pattern_known(size_t i) const { return i >= singletons.size(); }
+    size_t size() const { return singletons.size() + itemsets.size(); }
     size_t dimension() const { return singletons.dim; }
 
     template <typename T>
@@ -213,16 +321,20 @@ struct MaxEntFactor
     void insert_pattern(float_type label, const T& t, bool estimate)
     {
         itemsets.insert(label, t);
-        itemsets.num_singletons = singletons.set.size();
+        itemsets.num_singletons = singletons.size();
         if (estimate) { estimate_model(*this); }
+        else
+            estimated = false;
     }
 
     template <typename T>
     void insert_singleton(float_type label, T&& t, bool estimate)
     {
         singletons.insert(label, t);
-        itemsets.num_singletons = singletons.set.size();
+        itemsets.num_singletons = singletons.size();
         if (estimate) { estimate_model(*this); }
+        else
+            estimated = false;
     }
 
     template <typename T>
@@ -235,6 +347,16 @@ struct MaxEntFactor
         }
     }
 
+    void append(const MaxEntFactor& other)
+    {
+        singletons.append(other.singletons);
+        itemsets.append(other.itemsets);
+        itemsets.num_singletons = singletons.size();
+        // the joined distribution is the product of both, whose normalizers no longer
+        // satisfy the constraints of either factor
+        estimated = false;
+    }
+
     template <typename Pattern_Type>
     std::optional<float_type> get_precomputed_expectation(const Pattern_Type& x) const
     {
@@ -246,8 +368,7 @@ struct MaxEntFactor
 template <typename S, typename T, typename U>
 bool contains_pattern(const ItemsetModel<S, T>& m, const U& t)
 {
-    return std::any_of(
-        m.set.begin(), m.set.end(), [&](const auto& i) { return equal(i.point, t); });
+    return m.find(t) < m.size();
 }
 
 template <typename S, typename T, typename U>
@@ -260,7 +381,7 @@ template <typename S, typename T, typename U>
 bool contains_singleton(const SingletonModel<S, T>& m, const U& t)
 {
     return std::any_of(
-        m.set.begin(), m.set.end(), [&](const auto& i) { return is_subset(i.element, t); });
+        m.elements.begin(), m.elements.end(), [&](auto e) { return is_subset(e, t); });
 }
 
 template <typename S, typename T, typename U>
@@ -273,12 +394,9 @@ bool contains(const MaxEntFactor<S, T>& m, const U& t)
 template <typename S, typename T, typename U>
 bool erase_if(ItemsetModel<S, T>& m, const U& t)
 {
-    auto pos = std::find_if(
-        m.set.begin(), m.set.end(), [&](const auto& x) { return equal(x.point, t); });
-
-    if (pos != m.set.end())
+    if (auto i = m.find(t); i < m.size())
     {
-        m.set.erase(pos);
+        m.erase(i);
         return true;
     }
     return false;
@@ -286,13 +404,9 @@ bool erase_if(ItemsetModel<S, T>& m, const U& t)
 template <typename S, typename T, typename U>
 bool erase_if(SingletonModel<S, T>& m, const U& t)
 {
-    auto pos = std::find_if(m.set.begin(), m.set.end(), [elem = front(t)](const auto& x) {
-        return x.element == elem;
-    });
-
-    if (pos != m.set.end())
+    if (auto i = m.find(front(t)); i < m.size())
     {
-        m.set.erase(pos);
+        m.erase(i);
         return true;
     }
     return false;
@@ -305,32 +419,111 @@ bool erase_if(MaxEntFactor<S, T>& m, const U& t)
     return erase_if(m.itemsets, t);
 }
 
+// st is the signature of t
 template <typename pattern_type, typename float_type, typename query_type>
-auto probability(ItemsetModel<pattern_type, float_type> const& c, const query_type& t)
+auto probability(ItemsetModel<pattern_type, float_type> const& c,
+                 const query_type&                             t,
+                 signature_type                                st)
 {
     float_type acc = c.theta0;
-    for (size_t i = 0, l = c.set.size(); i < l; ++i)
+    for (size_t i = 0, l = c.size(); i < l; ++i)
     {
-        if (is_subset(c.set[i].point, t)) { acc *= c.set[i].theta; }
+        if (is_subset(c.points[i], c.signatures[i], t, st)) { acc *= c.thetas[i]; }
     }
     return acc;
 }
 
 template <typename pattern_type, typename float_type, typename query_type>
-auto probability(SingletonModel<pattern_type, float_type> const& c, query_type const& t)
+auto probability(SingletonModel<pattern_type, float_type> const& c,
+                 query_type const&                               t,
+                 signature_type                                  st)
 {
     float_type acc = c.theta0;
-    for (size_t i = 0, l = c.set.size(); i < l; ++i)
+    for (size_t i = 0, l = c.size(); i < l; ++i)
     {
-        if (is_subset(c.set[i].element, t)) { acc *= c.set[i].theta; }
+        const auto e = c.elements[i];
+        if (is_subset(e, signature(e), t, st)) { acc *= c.thetas[i]; }
     }
     return acc;
 }
 
+template <typename pattern_type, typename float_type, typename query_type>
+auto probability(MaxEntFactor<pattern_type, float_type> const& c,
+                 query_type const&                             t,
+                 signature_type                                st)
+{
+    return probability(c.itemsets, t, st) * probability(c.singletons, t, st);
+}
+
+template <typename pattern_type, typename float_type, typename query_type>
+auto probability(ItemsetModel<pattern_type, float_type> const& c, const query_type& t)
+{
+    return probability(c, t, signature(t));
+}
+
+template <typename pattern_type, typename float_type, typename query_type>
+auto probability(SingletonModel<pattern_type, float_type> const& c, query_type const& t)
+{
+    return probability(c, t, signature(t));
+}
+
 template <typename pattern_type, typename float_type, typename query_type>
 auto probability(MaxEntFactor<pattern_type, float_type> const& c, query_type const& t)
 {
-    return probability(c.itemsets, t) * probability(c.singletons, t);
+    return probability(c, t, signature(t));
+}
+
+/// natural logarithm of probability(c, t), without forming the product
+template <typename pattern_type, typename float_type, typename query_type>
+auto log_weight(MaxEntFactor<pattern_type, float_type> const& c,
+                query_type const&                             t,
+                signature_type                                st)
+{
+    using std::log;
+    float_type acc = log(c.itemsets.theta0) + log(c.singletons.theta0);
+    for (size_t i = 0, l = c.itemsets.size(); i < l; ++i)
+    {
+        if (is_subset(c.itemsets.points[i], c.itemsets.signatures[i], t, st))
+        {
+            acc += log(c.itemsets.thetas[i]);
+        }
+    }
+    for (size_t i = 0, l = c.singletons.size(); i < l; ++i)
+    {
+        const auto e = c.singletons.elements[i];
+        if (is_subset(e, signature(e), t, st)) { acc += log(c.singletons.thetas[i]); }
+    }
+    return acc;
+}
+
+/// natural logarithm of expectation_known, summed with log-sum-exp over the blocks
+template <typename Transactions, typename Model, typename Pattern>
+auto log_expectation_known(Transactions const& transactions,
+                           size_t              len,
+                           Model const&        model,
+                           Pattern const&      x)
+{
+    using float_type = typename Model::float_type;
+    using std::log;
+
+    const auto sx = signature(x);
+
+    LogSumExp<float_type> acc;
+    for (size_t i = 0; i < len; ++i)
+    {
+        const auto& t = transactions[i];
+        if (t.value != 0 && is_subset(x, sx, t.cover, t.signature))
+        {
+            acc += log(float_type(t.value)) + log_weight(model, t.cover, t.signature);
+        }
+    }
+    return acc.value();
+}
+
+template <typename Transactions, typename Model, typename Pattern>
+auto log_expectation_known(Transactions const& transactions, Model const& model, Pattern const& x)
+{
+    return log_expectation_known(transactions, transactions.size(), model, x);
 }
 
 template <typename Transactions, typename Model, typename Pattern>
@@ -340,21 +533,29 @@ auto expectation_known(Transactions const& transactions,
                        Pattern const&      x)
 {
     using float_type = typename Model::float_type;
+    using std::isinf, std::isnan, std::exp;
 
-    float_type p = 0;
+    const auto sx   = signature(x);
+    float_type p    = 0;
+    bool       seen = false;
 
     for (size_t i = 0; i < len; ++i)
     {
         const auto& t = transactions[i];
-        if (t.value != 0 && is_subset(x, t.cover))
+        if (t.value != 0 && is_subset(x, sx, t.cover, t.signature))
         {
-            p += t.value * probability(model, t.cover);
-            using std::isinf, std::isnan;
-            assert(!isnan(p));
-            assert(!isinf(p));
+            p += t.value * probability(model, t.cover, t.signature);
+            seen = true;
         }
     }
 
+    if (seen && (p < std::numeric_limits<float_type>::min() || isinf(p)))
+    {
+        // a product of coefficients left the range of float_type: redo it in log-space
+        p = exp(log_expectation_known(transactions, len, model, x));
+    }
+    assert(!isnan(p));
+
     return p;
 }
 
@@ -441,7 +642,7 @@ auto expectation_unknown(MaxEntFactor<S, T> const& model, disc::itemset<S> const
 {
     thread_local TempPartitionBuffer<S, T, 13> bf;
 
-    auto& b   = bf.get(model.itemsets.set.size() + 1);
+    auto& b   = bf.get(model.itemsets.size() + 1);
     auto  len = make_partitions_for_unknown(b, model, x);
 
     return expectation_known(b, len, model, x);
@@ -483,9 +684,12 @@ auto probability_of_absent_items(Model const& m, query_type const& t)
 {
     using float_type = typename Model::float_type;
     float_type p     = 1;
-    for (const auto& s : m.singletons.set)
+    for (size_t i = 0; i < m.singletons.size(); ++i)
     {
-        if (!is_subset(s.element, t)) { p *= float_type(1.0) - s.probability; }
+        if (!is_subset(m.singletons.element(i), t))
+        {
+            p *= float_type(1.0) - m.singletons.probability(i);
+        }
     }
     return p;
 }
@@ -496,9 +700,12 @@ auto log_probability_of_absent_items(Model const& m, query_type const& t)
     using std::log2;
     using float_type = typename Model::float_type;
     float_type p     = 0;
-    for (const auto& s : m.singletons.set)
+    for (size_t i = 0; i < m.singletons.size(); ++i)
     {
-        if (!is_subset(s.element, t)) { p += log2(float_type(1.0) - s.probability); }
+        if (!is_subset(m.singletons.element(i), t))
+        {
+            p += log2(float_type(1.0) - m.singletons.probability(i));
+        }
     }
     return p;
 }
@@ -1,12 +1,43 @@
-#if 0
 #pragma once
 
+#include <desc/distribution/IterativeScaling.hxx>
 #include <desc/distribution/StaticFactorModel.hxx>
-#include <setcover/GreedySetcover.hxx>
+
+#include <limits>
 
 namespace sd::disc
 {
 
+/// greedy weighted set cover: reports the set with the largest positive weight for the
+/// uncovered rest of x and removes it from x, until x is covered or no set has weight left.
+template <typename Sets, typename X, typename Report, typename Weight, typename Minus>
+void greedy_set_cover(const Sets& sets,
+                      X&          x,
+                      Report&&    report,
+                      size_t      max_sets,
+                      Weight&&    weight,
+                      Minus&&     minus)
+{
+    for (size_t k = 0; k < max_sets && count(x) > 0; ++k)
+    {
+        size_t best   = sets.size();
+        float  best_w = 0;
+        for (size_t i = 0; i < sets.size(); ++i)
+        {
+            const float w = weight(i, sets[i], x);
+            if (w > best_w)
+            {
+                best   = i;
+                best_w = w;
+            }
+        }
+        if (best == sets.size()) break;
+
+        report(best);
+        minus(x, sets[best]);
+    }
+}
+
 struct SetcoverWeightFunction
 {
     template <typename Set, typename To_Cover>
@@ -18,7 +49,7 @@ struct SetcoverWeightFunction
         {
             return std::numeric_limits<float>::max();
         }
-        const auto t = f.factor.itemsets.width();
+        const auto t = count(f.range);
         return s == t ? (static_cast<float>(s)) : -1.f;
     }
 };
@@ -51,7 +82,7 @@ struct WeightedSuperSetcoverWeightFunction
             return std::numeric_limits<float>::max();
         }
 
-        const auto t = f.factor.itemsets.width();
+        const auto t = count(f.range);
         return static_cast<float>(s) / (t - s + 1);
     }
 };
@@ -65,55 +96,115 @@ struct SetMinusFactor
     }
 };
 
+/// visits the factors that cover x, together with the part of x that each one covers.
+/// factors may overlap; the parts never do.
 template <typename U, typename X, typename Visitor>
-void factorize_patterns_dynamically(const std::vector<Factor<U>>& factors, X& x, Visitor&& f)
+void factorize_dynamically_into_parts(const Factorization<U>& phi, const X& x, Visitor&& f)
 {
     using W = SuperSetcoverWeightFunction;
-    setcover::greedy_set_cover(
-        factors,
-        x,
-        [&](size_t i) { f(factors[i], i); },
-        {1'000'000, -1},
+
+    thread_local itemset<typename U::pattern_type> y;
+    thread_local itemset<typename U::pattern_type> part;
+    y.assign(x);
+
+    greedy_set_cover(
+        phi.factors,
+        y,
+        [&](size_t i) {
+            part.clear();
+            intersection(y, phi.factors[i].range, part);
+            f(phi.factors[i], i, false, part);
+        },
+        1'000'000,
         W{},
         SetMinusFactor{});
+
+    foreach (y, [&](size_t i) {
+        part.clear();
+        part.insert(i);
+        f(phi.singleton_factors[i], i, true, part);
+    })
+        ;
+}
+
+template <typename U, typename X, typename Visitor>
+void factorize_patterns_dynamically(const std::vector<Factor<U>>& factors, X& x, Visitor&& f)
+{
+    using W = SuperSetcoverWeightFunction;
+    greedy_set_cover(
+        factors, x, [&](size_t i) { f(factors[i], i); }, 1'000'000, W{}, SetMinusFactor{});
 }
 
 template <typename U, typename X, typename Visitor>
 void factorize_dynamically(const Factorization<U>& phi, const X& x, Visitor&& f)
 {
-    thread_local itemset<typename U::pattern_type> y;
-    y.clear();
-    y.assign(x);
+    factorize_dynamically_into_parts(
+        phi, x, [&](const auto& phi_i, size_t i, bool s, const auto&) { f(phi_i, i, s); });
+}
 
-    factorize_patterns_dynamically(phi.factors, y, [&](const auto& phi_i, size_t i) { f(phi_i, i, false); });
-    foreach (y, [&](size_t i) { f(phi.singleton_factors[i], i, true); });
+/// unlike join_factors, skips the singletons and itemsets that an overlapping factor
+/// already contributed. the joined coefficients are no solution anymore.
+template <typename U>
+void join_overlapping_factors(Factor<U>& f, const Factor<U>& g)
+{
+    const auto& s = g.factor.singletons;
+    for (size_t i = 0; i < s.size(); ++i)
+    {
+        if (!is_subset(s.element(i), f.range))
+            f.factor.singletons.push_back(s.frequency(i), s.element(i));
+    }
+    const auto& xs = g.factor.itemsets;
+    for (size_t i = 0; i < xs.size(); ++i)
+    {
+        if (f.factor.itemsets.find(xs.point(i)) == f.factor.itemsets.size())
+            f.factor.itemsets.insert(xs.frequency(i), xs.point(i));
+    }
+    f.factor.itemsets.num_singletons = f.factor.singletons.size();
+    f.factor.estimated               = false;
+    f.range.insert(g.range);
+}
+
+template <typename U, typename V>
+void join_overlapping_factors(Factor<U>& f, const SingletonFactor<V>& g)
+{
+    if (!is_subset(g.element, f.range)) join_factors(f, g);
 }
 
 template <typename factor_type>
 void erase_uncovered_singletons(factor_type& f, bool estimate)
 {
-    auto&       s   = f.factor.singletons.set;
-    const auto& r   = f.range;
-    const auto  pos = std::remove_if(
-        s.begin(), s.end(), [&r](const auto& i) { return !is_subset(i.element, r); });
-
-    if (pos != s.end())
+    auto&       s      = f.factor.singletons;
+    const auto& r      = f.range;
+    bool        erased = false;
+    for (size_t i = s.size(); i-- > 0;)
     {
-        s.erase(pos, s.end());
+        if (!is_subset(s.element(i), r))
+        {
+            s.erase(i);
+            erased = true;
+        }
+    }
 
-        if (estimate) estimate_model(f.factor);
+    if (erased)
+    {
         f.factor.itemsets.num_singletons = f.factor.singletons.size();
+        if (estimate)
+            estimate_model(f.factor);
+        else
+            f.factor.estimated = false;
     }
 }
 
-template <typename factor_type, typename float_type, typename T>
-void create_mindiv_factor(factor_type& next,
-                          float_type   frequency,
-                          const T&     t,
-                          size_t       max_factor_size,
-                          size_t       max_factor_width,
-                          bool         estimate)
+template <typename factor_type, typename float_type, typename T, typename F>
+void create_mindiv_factor(factor_type&                       next,
+                          float_type                         frequency,
+                          const T&                           t,
+                          size_t                             max_factor_size,
+                          size_t                             max_factor_width,
+                          IterativeScalingSettings<F> const& opts)
 {
+    using std::log2, std::abs;
+
     assert(!is_singleton(t));
     // singletons + most informative next pattern
 
@@ -121,10 +212,11 @@ void create_mindiv_factor(factor_type& next,
 
     replacement.factor.singletons              = next.factor.singletons;
     replacement.factor.itemsets.num_singletons = replacement.factor.singletons.size();
+    replacement.factor.estimated               = false;
     replacement.range.insert(t);
-    replacement.factor.insert(frequency, t, estimate);
+    insert_and_estimate(replacement.factor, frequency, t, opts);
 
-    auto& xs = next.factor.itemsets.set;
+    const auto& xs = next.factor.itemsets;
 
     thread_local itemset<tag_dense> in_use;
     in_use.clear();
@@ -137,22 +229,16 @@ void create_mindiv_factor(factor_type& next,
         {
             if (in_use.test(j)) { continue; }
 
-            if (!intersects(xs[j].point, t))
-            {
-                in_use.insert(j);
-                continue;
-            }
-
-            if (size_of_union(xs[j].point, replacement.range) > max_factor_width)
+            if (!intersects(xs.point(j), t) ||
+                size_of_union(xs.point(j), replacement.range) > max_factor_width)
             {
                 in_use.insert(j);
                 continue;
             }
-            using std::log2, std::abs;
 
-            auto p = expectation(replacement.factor, xs[j].point);
-            auto q = xs[j].frequency;
-            auto g = abs(q * log2(q / p)) + (p * log2(p / q)); // assignment_score
+            auto p = expectation(replacement.factor, xs.point(j));
+            auto q = xs.frequency(j);
+            auto g = abs(q * log2(q / p)) + abs(p * log2(p / q)); // assignment_score
 
             if (g >= best.second) { best = {j, g}; }
         }
@@ -161,10 +247,9 @@ void create_mindiv_factor(factor_type& next,
         {
             ++count;
             in_use.insert(best.first);
-            const auto& y = xs[best.first].point;
-            const auto& q = xs[best.first].frequency;
-            replacement.range.insert(y);
-            replacement.factor.insert(q, y, estimate);
+            replacement.range.insert(xs.point(best.first));
+            insert_and_estimate(
+                replacement.factor, xs.frequency(best.first), xs.point(best.first), opts);
         }
         else
         {
@@ -172,72 +257,10 @@ void create_mindiv_factor(factor_type& next,
         }
     }
 
-    erase_uncovered_singletons(replacement, estimate);
+    erase_uncovered_singletons(replacement, true);
     next = std::move(replacement);
 }
 
-template <typename factor_type, typename T>
-void prune_factor_set_cover_based(factor_type& next,
-                                  const T&     t,
-                                  size_t       max_factor_size,
-                                  bool         estimate)
-{
-    auto&       is = next.factor.itemsets.set;
-    factor_type replacement(next.factor.singletons.dim);
-
-    auto weight = [](size_t, const auto& xs, const auto& ys) {
-        size_t s = sd::size_of_intersection(xs.point, ys);
-        return s;
-        // return s == count(xs.point) ? s : size_t(0);
-    };
-    auto setminus = [](auto& ys, const auto& xs) { sd::setminus(ys, xs.point); };
-    auto report   = [&](size_t i) {
-        replacement.factor.insert(is[i].frequency, is[i].point);
-        replacement.range.insert(is[i].point);
-    };
-
-    // setcover::greedy_set_cover_by_value(is, t, report, {max_factor_size - 1}, weight,
-    // setminus);
-    disc::itemset<disc::tag_dense> ignore(is.size());
-
-    setcover::greedy_set_cover_no_minus(ignore, is, t, report, {max_factor_size - 1}, weight);
-
-    for (const auto& i : next.factor.singletons.set)
-    {
-        if (is_subset(i.element, replacement.range))
-        {
-            replacement.factor.insert_singleton(i.frequency, i.element);
-        }
-    }
-    if (estimate) estimate_model(replacement.factor);
-    next = std::move(replacement);
-}
-
-template <typename factor_type, typename T>
-void prune_factor_overlapping_based(factor_type& next,
-                                    const T&     t,
-                                    size_t       max_factor_size,
-                                    bool         estimate)
-{
-    // keep most essential sets
-    auto& is = next.factor.itemsets.set;
-    std::sort(std::begin(is), std::end(is), [&t](const auto& a, const auto& b) {
-        return size_of_intersection(a.point, t) > size_of_intersection(b.point, t);
-    });
-    is.resize(max_factor_size);
-    next.range.clear();
-    for (const auto& i : is) { next.range.insert(i.point); }
-    next.range.insert(t);
-    auto& sset = next.factor.singletons.set;
-    sset.erase(std::remove_if(std::begin(sset),
-                              std::end(sset),
-                              [&](const auto& s) { return !is_subset(s.element, next.range); }),
-               std::end(sset));
-    next.factor.itemsets.num_singletons = sset.size();
-
-    if (estimate) estimate_model(next.factor);
-}
-
 template <typename U, typename V, typename Underlying_Factor_Type = MaxEntFactor<U, V>>
 struct RelaxedFactorModel
 {
@@ -254,6 +277,9 @@ struct RelaxedFactorModel
     size_t max_factor_size  = 5;
     size_t max_factor_width = 8;
 
+    IterativeScalingSettings<float_type> scaling{1e-8, 1e-10, 100, true};
+    bool                                 defer_estimation = false;
+
     Factorization<Underlying_Factor_Type> phi;
 
     size_t num_itemsets() const { return phi.factors.size(); }
@@ -264,19 +290,18 @@ struct RelaxedFactorModel
     {
         dim = d;
         clear();
-        init_singletons(phi.singleton_factors, dim);
+        init_singletons(phi, dim);
     }
 
     void clear()
     {
-        phi.factors.clear();
-        phi.singleton_factors.clear();
+        release_factors(phi, phi.factors.begin());
+        clear_singletons(phi);
     }
 
     void insert_singleton(float_type frequency, const index_type element, bool estimate)
     {
-        set_singleton(phi.singleton_factors, frequency, element, estimate);
-        // disc::insert_singleton(phi.singleton_factors, dim, frequency, element, estimate);
+        set_singleton(phi, frequency, element, estimate);
     }
 
     template <typename T>
@@ -285,55 +310,73 @@ struct RelaxedFactorModel
         insert_singleton(frequency, static_cast<index_type>(front(t)), estimate);
     }
 
+    template <typename T>
+    void insert_into_factor(factor_type& f, float_type frequency, const T& t, bool estimate)
+    {
+        if (estimate && defer_estimation)
+            disc::insert_deferred(f.factor, frequency, t, scaling);
+        else if (estimate)
+            insert_and_estimate(f.factor, frequency, t, scaling);
+        else
+            f.factor.insert(frequency, t, false);
+    }
+
     template <typename T>
     void insert_pattern_join_only_singletons(float_type frequency, const T& t, bool estimate)
     {
-        factor_type next(this->dim);
+        factor_type next = acquire_factor(phi, dim);
         foreach (t, [&](size_t i) { join_factors(next, phi.singleton_factors[i]); })
             ;
 
-        next.range.insert(t);
-        next.factor.insert(frequency, t, estimate);
+        insert_into_factor(next, frequency, t, estimate);
         phi.factors.emplace_back(std::move(next));
     }
 
+    /// the factor whose range contains t, or phi.factors.size()
     template <typename T>
-    void insert_pattern(float_type fr,
-                        const T&   t,
-                        size_t     max_size,
-                        size_t     max_width,
-                        bool       estimate)
+    size_t covering_factor(const T& t) const
     {
+        for (size_t j = 0; j < phi.factors.size(); ++j)
+        {
+            if (is_subset(t, phi.factors[j].range)) return j;
+        }
+        return phi.factors.size();
+    }
 
+    template <typename T>
+    void insert_pattern(
+        float_type frequency, const T& t, size_t max_size, size_t max_width, bool estimate)
+    {
         if (max_size <= 1)
         {
-            insert_pattern_join_only_singletons(fr, t, estimate);
+            insert_pattern_join_only_singletons(frequency, t, estimate);
             return;
         }
 
-        // itemset<U>  x_buf(t);
-        factor_type next(this->dim);
+        // a pattern within the range of one factor refines that factor, as in the static model
+        if (const auto j = covering_factor(t); j < phi.factors.size())
+        {
+            insert_into_factor(phi.factors[j], frequency, t, estimate);
+            return;
+        }
 
-        // factorize_dynamically(
-        //     *this, this->dim, x_buf, [&](auto& f, size_t, bool) { join_factors(next, f); });
+        factor_type next = acquire_factor(phi, dim);
 
         factorize_dynamically(
-            phi, t, [&](const auto& f, size_t, bool) { join_factors(next, f); });
+            phi, t, [&](const auto& f, size_t, bool) { join_overlapping_factors(next, f); });
 
-        const auto next_elems = next.factor.itemsets.set.size();
-        const auto next_items = next.factor.singletons.set.size();
-
-        if ((next_elems >= max_size || next_items > max_width))
+        if (next.factor.itemsets.size() >= max_size || next.factor.singletons.size() > max_width)
         {
-            create_mindiv_factor(next, fr, t, max_size, max_width, true);
+            // selecting the itemsets of the replacement needs estimates, so nothing is deferred
+            create_mindiv_factor(next, frequency, t, max_size, max_width, scaling);
         }
         else
         {
-            next.factor.insert(fr, t, estimate);
             next.range.insert(t);
+            insert_into_factor(next, frequency, t, estimate);
         }
 
-        this->phi.factors.emplace_back(std::move(next));
+        phi.factors.emplace_back(std::move(next));
     }
 
     template <typename T>
@@ -352,9 +395,57 @@ struct RelaxedFactorModel
     }
 
     template <typename T>
-    bool is_allowed(const T&, size_t, size_t) const
+    void insert_deferred(float_type frequency, const T& t)
     {
-        return true;
+        defer_estimation = true;
+        insert(frequency, t, true);
+        defer_estimation = false;
+    }
+
+    template <typename T>
+    void estimate_factors_of(const T& t)
+    {
+        factorize_dynamically(phi, t, [&](const auto& f, size_t i, bool) {
+            if constexpr (!is_singleton_factor<std::decay_t<decltype(f)>>)
+            {
+                if (!f.factor.estimated) estimate_model(phi.factors[i].factor, scaling);
+            }
+        });
+    }
+
+    void estimate_pending() { estimate_pending_factors(phi.factors, scaling); }
+
+    /// mirrors StaticFactorModel::is_allowed: t must be new to and fit into the factor that
+    /// covers it, or joining the factors of its cover must not exceed max_size or max_width.
+    /// overlapping ranges are counted once.
+    template <typename T>
+    bool is_allowed(const T& t, size_t max_size, size_t max_width) const
+    {
+        if (is_singleton(t)) return true;
+
+        if (const auto j = covering_factor(t); j < phi.factors.size())
+        {
+            const auto& xs = phi.factors[j].factor.itemsets;
+            return xs.find(t) == xs.size() && xs.size() < max_size;
+        }
+
+        thread_local itemset<pattern_type> range;
+        range.clear();
+
+        size_t total_size = 0;
+        factorize_dynamically(phi, t, [&](const auto& f, size_t, bool) {
+            if constexpr (is_singleton_factor<std::decay_t<decltype(f)>>)
+            {
+                range.insert(f.element);
+            }
+            else
+            {
+                total_size += f.factor.itemsets.size();
+                range.insert(f.range);
+            }
+        });
+
+        return total_size < max_size && count(range) < max_width;
     }
 
     template <typename T>
@@ -363,6 +454,7 @@ struct RelaxedFactorModel
         return is_allowed(t, max_factor_size, max_factor_width);
     }
 };
+
 template <typename S, typename T, typename U, typename X, typename Visitor>
 void factorize(const RelaxedFactorModel<S, T, U>& pr, const X& x, Visitor&& f)
 {
@@ -372,14 +464,12 @@ template <typename U, typename V, typename X, typename Visitor>
 void factorize_patterns(const RelaxedFactorModel<U, V>& pr, const X& x, Visitor&& f)
 {
     thread_local itemset<typename RelaxedFactorModel<U, V>::pattern_type> y;
-    y.clear();
     y.assign(x);
 
     factorize_patterns_dynamically(pr.phi.factors, y, f);
 }
 template <typename S, typename T, typename U, typename F = double>
-void estimate_model(RelaxedFactorModel<S, T, U>&       m,
-                    IterativeScalingSettings<F> const& opts = {})
+void estimate_model(RelaxedFactorModel<S, T, U>& m, IterativeScalingSettings<F> const& opts = {})
 {
     estimate_model(m.phi.factors, opts);
 }
@@ -388,5 +478,5 @@ void factorize_singletons(const RelaxedFactorModel<S, T, U>& pr, const X& x, Vis
 {
     factorize_singletons(pr.phi, x, std::forward<Visitor>(v));
 }
+
 } // namespace sd::disc
-#endif
\ No newline at end of file
@@ -3,6 +3,11 @@
 #include <desc/distribution/IterativeScaling.hxx>
 #include <desc/distribution/MaxEntFactor.hxx>
 #include <desc/storage/Itemset.hxx>
+#include <math/Summation.hxx>
+
+#include <algorithm>
+#include <limits>
+#include <vector>
 
 #ifndef NDEBUG
 #include <exception>
@@ -25,28 +30,116 @@ struct Factor
     explicit Factor(size_t dim) : factor(dim) { range.reserve(dim); }
     itemset<pattern_type>  range;
     Underlying_Factor_Type factor;
+
+    void reset(size_t dim)
+    {
+        range.clear();
+        range.reserve(dim);
+        factor.reset(dim);
+    }
 };
 
-template <typename U>
-void join_factors(Factor<U>& f, const Factor<U>& g)
+/// recycled objects of a model. the pool only holds allocations, not state, hence copies
+/// of a model start with an empty pool.
+template <typename T>
+struct SparePool
+{
+    std::vector<T> items;
+
+    SparePool() = default;
+    SparePool(const SparePool&) {}
+    SparePool(SparePool&&) noexcept = default;
+    SparePool& operator=(const SparePool&) { return *this; }
+    SparePool& operator=(SparePool&&) noexcept = default;
+};
+
+template <typename V>
+struct SingletonFactor
 {
-    for (auto& t : g.factor.itemsets.set) f.factor.insert_pattern(t.frequency, t.point, false);
+    using float_type = V;
+
+    size_t     element;
+    float_type frequency   = 0.5;
+    float_type theta       = 1;
+    float_type probability = 0.5;
+};
 
-    for (auto& t : g.factor.singletons.set)
-        f.factor.insert_singleton(t.frequency, t.element, false);
+template <typename T>
+constexpr bool is_singleton_factor = false;
+template <typename V>
+constexpr bool is_singleton_factor<SingletonFactor<V>> = true;
 
+template <typename U>
+void join_factors(Factor<U>& f, const Factor<U>& g)
+{
+    f.factor.append(g.factor);
     f.range.insert(g.range);
 }
 
+template <typename U, typename V>
+void join_factors(Factor<U>& f, const SingletonFactor<V>& g)
+{
+    f.factor.singletons.push_back(g.frequency, g.element, g.theta, g.probability);
+    f.factor.itemsets.num_singletons = f.factor.singletons.size();
+    f.factor.estimated               = false; // see MaxEntFactor::append
+    f.range.insert(g.element);
+}
+
 template <typename U>
 struct Factorization
 {
     using float_type = typename U::float_type;
 
-    std::vector<Factor<U>> singleton_factors;
-    std::vector<Factor<U>> factors;
+    constexpr static size_t no_factor = std::numeric_limits<size_t>::max();
+
+    std::vector<SingletonFactor<float_type>> singleton_factors;
+    std::vector<Factor<U>>                   factors;
+    // item -> index into factors, or no_factor if the item is only covered by its singleton
+    std::vector<size_t> item_to_factor;
+    SparePool<Factor<U>> spare;
+    // log2(1 - p_i) of every singleton factor and their sum over all items
+    std::vector<float_type>    log_absent;
+    CompensatedSum<float_type> log_absent_total;
 };
 
+template <typename U>
+Factor<U> acquire_factor(Factorization<U>& phi, size_t dim)
+{
+    auto& spare = phi.spare.items;
+    if (spare.empty()) return Factor<U>(dim);
+    auto f = std::move(spare.back());
+    spare.pop_back();
+    f.reset(dim);
+    return f;
+}
+
+template <typename U>
+void release_factors(Factorization<U>& phi, typename std::vector<Factor<U>>::iterator first)
+{
+    auto& spare = phi.spare.items;
+    spare.insert(spare.end(), std::make_move_iterator(first), std::make_move_iterator(phi.factors.end()));
+    phi.factors.erase(first, phi.factors.end());
+}
+
+template <typename U>
+void reindex_factors(Factorization<U>& phi)
+{
+    // overlapping factors, as in the relaxed model, keep no index
+    if (phi.item_to_factor.empty()) return;
+
+    std::fill(phi.item_to_factor.begin(), phi.item_to_factor.end(), Factorization<U>::no_factor);
+    for (size_t j = 0; j < phi.factors.size(); ++j)
+    {
+        foreach (phi.factors[j].range, [&](size_t i) { phi.item_to_factor[i] = j; })
+            ;
+    }
+}
+
+template <typename Phi>
+void reindex_factors(Phi&)
+{
+}
+
 template <typename U>
 void init_singletons(std::vector<Factor<U>>& factors, size_t dim)
 {
@@ -61,6 +154,65 @@ void init_singletons(std::vector<Factor<U>>& factors, size_t dim)
     }
 }
 
+template <typename V>
+void init_singletons(std::vector<SingletonFactor<V>>& factors, size_t dim)
+{
+    factors.resize(dim);
+    for (size_t i = 0; i < dim; ++i) { factors[i] = {i}; }
+}
+
+template <typename V>
+void set_singleton(std::vector<SingletonFactor<V>>& factors,
+                   V                                frequency,
+                   const size_t                     element,
+                   bool                             estimate)
+{
+    auto& f     = factors[element];
+    f.frequency = frequency;
+    if (estimate)
+    {
+        // closed form of a factor without itemsets, see estimate_singletons
+        f.theta       = 2 * frequency;
+        f.probability = frequency;
+    }
+}
+
+template <typename U>
+void init_singletons(Factorization<U>& phi, size_t dim)
+{
+    using std::log2;
+    using float_type = typename U::float_type;
+
+    init_singletons(phi.singleton_factors, dim);
+    phi.log_absent.assign(dim, log2(float_type(1) - SingletonFactor<float_type>{}.probability));
+    phi.log_absent_total.reset();
+    for (const auto& l : phi.log_absent) phi.log_absent_total += l;
+}
+
+template <typename U>
+void clear_singletons(Factorization<U>& phi)
+{
+    phi.singleton_factors.clear();
+    phi.log_absent.clear();
+    phi.log_absent_total.reset();
+}
+
+template <typename U, typename float_type>
+void set_singleton(Factorization<U>& phi,
+                   float_type        frequency,
+                   const size_t      element,
+                   bool              estimate)
+{
+    using std::log2;
+
+    set_singleton(phi.singleton_factors, frequency, element, estimate);
+
+    const auto l = log2(float_type(1) - phi.singleton_factors[element].probability);
+    phi.log_absent_total += -phi.log_absent[element];
+    phi.log_absent_total += l;
+    phi.log_absent[element] = l;
+}
+
 template <typename U, typename float_type>
 void set_singleton(std::vector<Factor<U>>& factors,
                    float_type              frequency,
@@ -108,13 +260,35 @@ void estimate_model(std::vector<U>& phi, IterativeScalingSettings<F> const& opts
 #endif
 }
 
+template <typename U, typename F = double>
+void estimate_pending_factors(std::vector<U>& phi, IterativeScalingSettings<F> const& opts = {})
+{
+#if HAS_EXECUTION_POLICIES
+    std::for_each(std::execution::par_unseq, phi.begin(), phi.end(), [opts](auto& f) {
+        if (!f.factor.estimated) estimate_model(f.factor, opts);
+    });
+#else
+#pragma omp parallel for schedule(dynamic, 1)
+    for (size_t i = 0; i < phi.size(); ++i)
+    {
+        if (!phi[i].factor.estimated) estimate_model(phi[i].factor, opts);
+    }
+#endif
+}
+
 template <typename U>
 void erase_empty_factors(Factorization<U>& phi)
 {
-    phi.factors.erase(std::remove_if(phi.factors.begin(),
-                                     phi.factors.end(),
-                                     [](auto& f) { return f.range.empty(); }),
-                      phi.factors.end());
+    // like remove_if, but swaps so that the erased factors keep their storage
+    auto keep = phi.factors.begin();
+    for (auto it = phi.factors.begin(); it != phi.factors.end(); ++it)
+    {
+        if (it->range.empty()) continue;
+        if (keep != it) std::swap(*keep, *it);
+        ++keep;
+    }
+    release_factors(phi, keep);
+    reindex_factors(phi);
     // phi.singleton_factors.erase(
     //     std::remove_if(phi.singleton_factors.begin(), phi.singleton_factors.end(), [](auto&
     //     f) { return f.range.empty(); }), phi.singleton_factors.end());
@@ -147,15 +321,24 @@ void factorize_statically(const Factorization<Underlying_Factor_Type>& phi,
                           const X&                                     x,
                           Visitor&&                                    f)
 {
-    using pattern_type = typename Underlying_Factor_Type::pattern_type;
+    constexpr auto no_factor = Factorization<Underlying_Factor_Type>::no_factor;
 
-    thread_local itemset<pattern_type> y;
-    y.clear();
-    y.assign(x);
+    thread_local std::vector<size_t> hits;
+    hits.clear();
 
-    factorize_patterns_statically(
-        phi.factors, y, [&](const auto& phi_i, size_t i) { f(phi_i, i, false); });
-    foreach (y, [&](size_t i) { f(phi.singleton_factors[i], i, true); })
+    foreach (x, [&](size_t i) {
+        if (auto j = phi.item_to_factor[i]; j != no_factor) hits.push_back(j);
+    })
+        ;
+
+    std::sort(hits.begin(), hits.end());
+    hits.erase(std::unique(hits.begin(), hits.end()), hits.end());
+
+    for (auto j : hits) { f(phi.factors[j], j, false); }
+
+    foreach (x, [&](size_t i) {
+        if (phi.item_to_factor[i] == no_factor) f(phi.singleton_factors[i], i, true);
+    })
         ;
 }
 
@@ -177,6 +360,9 @@ struct StaticFactorModel
     size_t max_factor_size  = 5;
     size_t max_factor_width = 8;
 
+    IterativeScalingSettings<float_type> scaling{1e-8, 1e-10, 100, true};
+    bool                                 defer_estimation = false;
+
     Factorization<Underlying_Factor_Type> phi;
 
     size_t num_itemsets() const { return phi.factors.size(); }
@@ -187,18 +373,20 @@ struct StaticFactorModel
     {
         dim = d;
         clear();
-        init_singletons(phi.singleton_factors, dim);
+        init_singletons(phi, dim);
+        phi.item_to_factor.assign(dim, phi.no_factor);
     }
 
     void clear()
     {
-        phi.factors.clear();
-        phi.singleton_factors.clear();
+        release_factors(phi, phi.factors.begin());
+        clear_singletons(phi);
+        phi.item_to_factor.clear();
     }
 
     void insert_singleton(float_type frequency, const index_type element, bool estimate)
     {
-        set_singleton(phi.singleton_factors, frequency, element, estimate);
+        set_singleton(phi, frequency, element, estimate);
         // disc::insert_singleton(phi.singleton_factors, dim, frequency, element, estimate);
     }
 
@@ -212,10 +400,21 @@ struct StaticFactorModel
     {
         if constexpr (enable_factor_pruning)
         {
-            if (f.factor.itemsets.set.size() > 3) { prune_factor(f, max_size); }
+            if (f.factor.itemsets.size() > 3) { prune_factor(f, max_size, scaling.statistics); }
         }
     }
 
+    template <typename T>
+    void insert_into_factor(factor_type& f, float_type frequency, const T& t, bool estimate)
+    {
+        if (estimate && defer_estimation)
+            disc::insert_deferred(f.factor, frequency, t, scaling);
+        else if (estimate)
+            insert_and_estimate(f.factor, frequency, t, scaling);
+        else
+            f.factor.insert(frequency, t, false);
+    }
+
     template <typename T>
     void insert_pattern(
         float_type frequency, const T& t, size_t max_size, size_t max_width, bool estimate)
@@ -226,15 +425,19 @@ struct StaticFactorModel
 
         bool found_superset = false;
         factorize_statically(phi, t, [&](const auto& f, size_t i, bool from_singleton) {
-            if (!found_superset)
+            if constexpr (is_singleton_factor<std::decay_t<decltype(f)>>)
+            {
+                if (!found_superset) selection.emplace_back(i, from_singleton);
+            }
+            else if (!found_superset)
             {
                 if (is_subset(t, f.range) && !from_singleton)
                 {
-                    if (f.factor.itemsets.set.size() < max_size)
+                    if (f.factor.itemsets.size() < max_size)
                     {
                         auto& phi_i = phi.factors[i];
                         if (estimate) prune_factor_if(phi_i, max_size);
-                        phi_i.factor.insert(frequency, t, estimate);
+                        insert_into_factor(phi_i, frequency, t, estimate);
                     }
                     found_superset = true;
                     return;
@@ -248,23 +451,27 @@ struct StaticFactorModel
 
         if (selection.empty() || found_superset) { return; }
 
-        factor_type next(dim);
+        factor_type next = acquire_factor(phi, dim);
 
         for (const auto& [i, s] : selection)
         {
-            join_factors(next, s ? phi.singleton_factors[i] : phi.factors[i]);
+            if (s)
+                join_factors(next, phi.singleton_factors[i]);
+            else
+                join_factors(next, phi.factors[i]);
         }
 
-        if (count(next.range) > max_width || next.factor.itemsets.set.size() > max_size)
+        if (count(next.range) > max_width || next.factor.itemsets.size() > max_size)
         {
             // #ifndef NDEBUG
             //             throw std::domain_error{"pattern too large or factor is full"};
             // #endif
+            phi.spare.items.push_back(std::move(next));
             return;
         }
 
         if (estimate) prune_factor_if(next, max_size);
-        next.factor.insert(frequency, t, estimate);
+        insert_into_factor(next, frequency, t, estimate);
 
         for (auto [i, s] : selection)
         {
@@ -273,6 +480,8 @@ struct StaticFactorModel
         selection.clear();
 
         erase_empty_factors(phi);
+        foreach (next.range, [&](size_t i) { phi.item_to_factor[i] = phi.factors.size(); })
+            ;
         phi.factors.emplace_back(std::move(next));
     }
 
@@ -291,6 +500,30 @@ struct StaticFactorModel
             insert_pattern(frequency, t, estimate);
     }
 
+    /// routes t to its factor like insert, but leaves the solve to estimate_factors_of or
+    /// estimate_pending. the pending factor is only marked if its solution violates t.
+    template <typename T>
+    void insert_deferred(float_type frequency, const T& t)
+    {
+        defer_estimation = true;
+        insert(frequency, t, true);
+        defer_estimation = false;
+    }
+
+    /// brings every factor that t touches up to date, so that queries for t are exact.
+    template <typename T>
+    void estimate_factors_of(const T& t)
+    {
+        factorize_statically(phi, t, [&](const auto& f, size_t i, bool) {
+            if constexpr (!is_singleton_factor<std::decay_t<decltype(f)>>)
+            {
+                if (!f.factor.estimated) estimate_model(phi.factors[i].factor, scaling);
+            }
+        });
+    }
+
+    void estimate_pending() { estimate_pending_factors(phi.factors, scaling); }
+
     template <typename T>
     bool is_allowed(const T& t, size_t max_size, size_t max_width) const
     {
@@ -299,15 +532,28 @@ struct StaticFactorModel
         bool   found_superset = false;
 
         factorize_statically(phi, t, [&](const auto& f, size_t, bool) {
-            if (is_subset(t, f.range))
+            if constexpr (is_singleton_factor<std::decay_t<decltype(f)>>)
+            {
+                if (is_singleton(t))
+                {
+                    found_superset = true;
+                    total_size     = 0;
+                    total_width    = 1;
+                }
+                else if (!found_superset)
+                {
+                    total_width += 1;
+                }
+            }
+            else if (is_subset(t, f.range))
             {
                 found_superset = true;
-                total_size     = f.factor.itemsets.set.size();
-                total_width    = f.factor.singletons.set.size();
+                total_size     = f.factor.itemsets.size();
+                total_width    = f.factor.singletons.size();
             }
             else if (!found_superset)
             {
-                total_size += f.factor.itemsets.set.size();
+                total_size += f.factor.itemsets.size();
                 total_width += count(f.range);
             }
         });
@@ -330,11 +576,9 @@ void factorize(const StaticFactorModel<S, T, U>& pr, const X& x, Visitor&& f)
 template <typename U, typename V, typename X, typename Visitor>
 void factorize_patterns(const StaticFactorModel<U, V>& pr, const X& x, Visitor&& f)
 {
-    thread_local itemset<typename StaticFactorModel<U, V>::pattern_type> y;
-    y.clear();
-    y.assign(x);
-
-    factorize_patterns_statically(pr.phi.factors, y, f);
+    factorize_statically(pr.phi, x, [&](const auto& phi_i, size_t i, bool) {
+        if constexpr (!is_singleton_factor<std::decay_t<decltype(phi_i)>>) f(phi_i, i);
+    });
 }
 template <typename S, typename T, typename U, typename F = double>
 void estimate_model(StaticFactorModel<S, T, U>& m, IterativeScalingSettings<F> const& opts = {})
@@ -396,7 +640,7 @@ struct ClassicStaticFactorModel
     {
         if constexpr (enable_factor_pruning)
         {
-            if (f.factor.itemsets.set.size() > 3) { prune_factor(f, max_factor_size); }
+            if (f.factor.itemsets.size() > 3) { prune_factor(f, max_factor_size); }
         }
     }
 
@@ -415,7 +659,7 @@ struct ClassicStaticFactorModel
             auto& f = phi.factors[i];
             if (is_subset(t, f.range))
             {
-                if (f.factor.itemsets.set.size() < max_factor_size)
+                if (f.factor.itemsets.size() < max_factor_size)
                 {
                     if (estimate) prune_factor_if(f, max_factor_size);
                     f.factor.insert(frequency, t, estimate);
@@ -432,7 +676,7 @@ struct ClassicStaticFactorModel
         for (const auto& s : selection) { join_factors(next, phi.factors[s]); }
 
         if (count(next.range) > max_factor_width ||
-            next.factor.itemsets.set.size() > max_factor_size)
+            next.factor.itemsets.size() > max_factor_size)
         {
             // #ifndef NDEBUG
             //             throw std::domain_error{"pattern too large or factor is full"};
@@ -467,6 +711,22 @@ struct ClassicStaticFactorModel
             insert_pattern(frequency, t, estimate);
     }
 
+    template <typename T>
+    void insert_deferred(value_type frequency, const T& t)
+    {
+        insert(frequency, t, false);
+    }
+
+    template <typename T>
+    void estimate_factors_of(const T& t)
+    {
+        factorize_classic(phi.factors, t, [&](const auto& f, size_t i) {
+            if (!f.factor.estimated) estimate_model(phi.factors[i].factor);
+        });
+    }
+
+    void estimate_pending() { estimate_pending_factors(phi.factors); }
+
     template <typename T>
     bool is_allowed(const T& t, size_t max_factor_size, size_t max_factor_width) const
     {
@@ -476,12 +736,12 @@ struct ClassicStaticFactorModel
         {
             if (is_subset(t, f.range))
             {
-                return f.factor.itemsets.set.size() < max_factor_size;
+                return f.factor.itemsets.size() < max_factor_size;
             }
             if (intersects(t, f.range))
             {
                 // this works, because all factors are covering disjoint sets
-                total_size += f.factor.itemsets.set.size();
+                total_size += f.factor.itemsets.size();
                 total_width += count(f.range);
                 if (total_size >= max_factor_size || total_width >= max_factor_width)
                     return false;
@@ -532,14 +792,14 @@ template <typename S, typename T, typename U, typename X, typename Visitor>
 void factorize(const ClassicStaticFactorModel<S, T, U>& pr, const X& x, Visitor&& v)
 {
     factorize_classic(pr.phi.factors, x, [&](const auto& f, size_t i) {
-        v(f, i, f.factor.singletons.set.size() == 1);
+        v(f, i, f.factor.singletons.size() == 1);
     });
 }
 template <typename U, typename V, typename X, typename Visitor>
 void factorize_patterns(const ClassicStaticFactorModel<U, V>& pr, const X& x, Visitor&& v)
 {
     factorize_classic(pr.phi.factors, x, [&](const auto& f, size_t i) {
-        if (f.factor.singletons.set.size() != 1) v(f, i);
+        if (f.factor.singletons.size() != 1) v(f, i);
     });
 }
 template <typename S, typename T, typename U, typename F = double>
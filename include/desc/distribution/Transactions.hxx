@@ -54,6 +54,7 @@ struct Block
     count_type       value{0};
     count_type       count{0};
     disc::itemset<U> cover;
+    signature_type   signature{0}; // of cover
 
     bool operator<(Block const& rhs) const { return count < rhs.count; }
 };
@@ -76,6 +77,7 @@ size_t generate_blocks_long(size_t dim, model_type const& m, block_container_typ
         blocks[0].count = k;
         // blocks[0].cover.resize(dim);
         blocks[0].cover.clear();
+        blocks[0].signature = 0;
 
         // blocks       = {{k, k, disc::itemset<pattern_type>(dim)}};
 
@@ -95,7 +97,7 @@ size_t generate_blocks_long(size_t dim, model_type const& m, block_container_typ
 
         const auto k = exp2(float_type(dim) - float_type(count(cover)));
         assert(k > 0);
-        blocks.push_back({k, k, cover});
+        blocks.push_back({k, k, cover, signature(cover)});
 
         if (count(i) == size)
             break;
@@ -124,12 +126,13 @@ void generate_blocks_and_counts_long(size_t                dim,
         for (size_t j = 0; j < i; ++j)
         {
             auto& a = blocks[j];
-            if (is_subset(b.cover, a.cover))
+            if (is_subset(b.cover, b.signature, a.cover, a.signature))
             {
                 if (count(b.cover) == count(a.cover) && equal(a.cover, b.cover))
                 {
                     b.value = 0;
                     b.cover.clear();
+                    b.signature = 0;
                     break;
                 }
                 assert(b.value - a.value >= 0);
@@ -163,6 +166,7 @@ size_t generate_blocks_and_counts(size_t dim, model_type const& m, block_contain
         auto& block = blocks.front();
 
         block.cover.clear();
+        block.signature = 0;
 
         const auto k = exp2(width);
         block.value  = k;
@@ -187,6 +191,7 @@ size_t generate_blocks_and_counts(size_t dim, model_type const& m, block_contain
         block.cover.reserve(dim);
 
         foreach(i, [&](size_t j) { block.cover.insert(m.point(j)); });
+        block.signature = signature(block.cover);
 
         const auto cnt_block  = count(block.cover);
         const auto cover_size = static_cast<float_type>(cnt_block);
@@ -201,13 +206,15 @@ size_t generate_blocks_and_counts(size_t dim, model_type const& m, block_contain
 
         for (size_t prev = 0; prev < index; ++prev)
         {
-            if (is_subset(block.cover, blocks[prev].cover))
+            if (is_subset(
+                    block.cover, block.signature, blocks[prev].cover, blocks[prev].signature))
             {
                 // if (cnt_block == count(blocks[prev].cover))
                 if (block.count == blocks[prev].count)
                 {
                     block.value = 0;
                     block.cover.clear();
+                    block.signature = 0;
                     break;
                 }
                 else
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <boost/iterator/indirect_iterator.hpp>
+
+#include <cassert>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace sd::disc
+{
+
+/// a vector whose copies share their elements: an element is copied only when it is accessed
+/// through a non-const reference while another copy still holds it. read through a const
+/// reference to keep an element shared.
+template <typename T>
+struct CopyOnWriteVector
+{
+    using value_type   = T;
+    using element_type = std::shared_ptr<T>;
+    using container    = std::vector<element_type>;
+
+    using iterator       = boost::indirect_iterator<typename container::iterator>;
+    using const_iterator = boost::indirect_iterator<typename container::const_iterator, const T>;
+
+    size_t size() const { return elements.size(); }
+    bool   empty() const { return elements.empty(); }
+
+    void resize(size_t n)
+    {
+        const auto k = elements.size();
+        elements.resize(n);
+        for (size_t i = k; i < n; ++i) elements[i] = std::make_shared<T>();
+    }
+    void push_back(T x) { elements.push_back(std::make_shared<T>(std::move(x))); }
+    void clear() { elements.clear(); }
+
+    iterator erase(const_iterator it) { return iterator(elements.erase(it.base())); }
+
+    const T& operator[](size_t i) const { return *elements[i]; }
+    T&       operator[](size_t i) { return unique(i); }
+
+    const T& front() const { return *elements.front(); }
+    const T& back() const { return *elements.back(); }
+    T&       front() { return unique(0); }
+    T&       back() { return unique(elements.size() - 1); }
+
+    const_iterator begin() const { return const_iterator(elements.cbegin()); }
+    const_iterator end() const { return const_iterator(elements.cend()); }
+    iterator       begin()
+    {
+        for (size_t i = 0; i < elements.size(); ++i) unique(i);
+        return iterator(elements.begin());
+    }
+    iterator end() { return iterator(elements.end()); }
+
+    /// whether the element is held by another copy as well
+    bool is_shared(size_t i) const { return elements[i].use_count() > 1; }
+
+    /// the element for being overwritten as a whole: if it is shared, it is replaced by a
+    /// default constructed element instead of a copy.
+    T& overwrite(size_t i)
+    {
+        if (is_shared(i)) elements[i] = std::make_shared<T>();
+        return *elements[i];
+    }
+
+private:
+    T& unique(size_t i)
+    {
+        assert(i < elements.size());
+        if (is_shared(i)) elements[i] = std::make_shared<T>(std::as_const(*elements[i]));
+        return *elements[i];
+    }
+
+    container elements;
+};
+
+} // namespace sd::disc
@@ -4,6 +4,10 @@
 
 #include <datatable/data_table.hxx>
 
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
 namespace sd::disc
 {
 
@@ -90,6 +94,11 @@ struct Dataset : public sd::df::col_store<S>
             point(this->size() - 1).container.shrink_to_fit();
         }
         dim = std::max(dim, get_dim(point(this->size() - 1)));
+        if (!weights.empty())
+        {
+            weights.push_back(1);
+            total_weight += 1;
+        }
     }
 
     void insert(itemset<pattern_type> const & t)
@@ -129,9 +138,73 @@ struct Dataset : public sd::df::col_store<S>
 
     size_t capacity() const { return this->template col<0>().capacity(); }
 
+    /// how often the row occurs in the original data, see deduplicate_rows
+    size_t weight(size_t index) const { return weights.empty() ? 1 : weights[index]; }
+    /// number of rows of the original data, counting duplicates
+    size_t num_rows() const { return weights.empty() ? this->size() : total_weight; }
+
     size_t dim = 0;
+
+    std::vector<size_t> weights; // empty if every row occurs once
+    size_t              total_weight = 0;
 };
 
+/// collapses identical rows into the first of them, weighted by the number of copies. if
+/// labels are given, only rows with the same label are identical and the labels are collapsed
+/// accordingly. returns the index of the remaining row for every original row.
+template <typename S>
+std::vector<size_t> deduplicate_rows(Dataset<S>& data, std::vector<size_t>* labels = nullptr)
+{
+    assert(!labels || labels->size() == data.size());
+
+    std::vector<size_t> unique_of_row(data.size());
+    std::unordered_multimap<size_t, size_t> first_of_hash;
+    first_of_hash.reserve(data.size());
+
+    Dataset<S>          out;
+    std::vector<size_t> out_labels;
+    out.reserve(data.size());
+    out.weights.reserve(data.size());
+
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        const auto& x = data.point(i);
+        const auto  y = labels ? (*labels)[i] : size_t(0);
+
+        size_t h = y ^ 0xcbf29ce484222325;
+        foreach (x, [&](size_t j) { h = (h ^ j) * 0x100000001b3; })
+            ;
+
+        size_t u          = out.size();
+        auto [first, last] = first_of_hash.equal_range(h);
+        for (auto it = first; it != last; ++it)
+        {
+            const auto k = it->second;
+            if ((!labels || out_labels[k] == y) && sd::equal(out.point(k), x))
+            {
+                u = k;
+                break;
+            }
+        }
+
+        if (u == out.size())
+        {
+            first_of_hash.emplace(h, u);
+            out.push_back(std::move(data.point(i)));
+            out.weights.push_back(0);
+            if (labels) out_labels.push_back(y);
+        }
+        out.weights[u] += 1;
+        unique_of_row[i] = u;
+    }
+
+    out.dim          = data.dim;
+    out.total_weight = data.size();
+    data             = std::move(out);
+    if (labels) *labels = std::move(out_labels);
+    return unique_of_row;
+}
+
 template <typename L, typename S>
 struct LabeledDataset : public sd::df::col_store<L, S>
 {
@@ -280,8 +353,10 @@ void swap(itemset_view<T>& a, itemset_view<T>& b)
     std::swap(a, b);
 }
 
+/// rows are (label, itemset, original position, signature of the itemset)
 template <typename S>
-struct PartitionedData : public sd::df::col_store<size_t, itemset_view<S>, size_t>
+struct PartitionedData
+    : public sd::df::col_store<size_t, itemset_view<S>, size_t, signature_type>
 {
     using pattern_type = S;
 
@@ -345,40 +420,120 @@ struct PartitionedData : public sd::df::col_store<size_t, itemset_view<S>, size_
         assert(data->size() == this->size());
         for (size_t i = 0; i < this->size(); ++i)
         {
-            point(i) = make_view(data->point(i));
+            point(i)     = make_view(data->point(i));
+            signature(i) = sd::signature(point(i));
             assert(sd::equal(point(i), data->point(i)));
         }
     }
 
     void revert_order()
     {
-        std::sort(this->begin(), this->end(), [](const auto& a, const auto& b) {
-            return get<2>(a) < get<2>(b);
-        });
+        const auto& ol = this->template col<2>();
+        permute(0, std::vector<size_t>(ol.begin(), ol.end()));
         positions.clear();
+        component_labels.clear();
+        accumulate_weights();
     }
 
+    /// sorts the rows stably by label. the labels are counted into buckets if they are small,
+    /// which they are unless they were given by the user.
     void group_by_label()
     {
-        auto lt = [](const auto& a, const auto& b) { return get<0>(a) < get<0>(b); };
+        auto&        labels = this->template col<0>();
+        const size_t n      = labels.size();
 
         positions.clear();
+        component_labels.clear();
 
-        std::sort(this->begin(), this->end(), lt);
+        const size_t largest = n == 0 ? 0 : *std::max_element(labels.begin(), labels.end());
+        if (largest <= 2 * n + 64)
+        {
+            std::vector<size_t> first(largest + 2, 0);
+            for (const auto& l : labels) ++first[l + 1];
+            for (size_t l = 0; l <= largest; ++l)
+            {
+                if (first[l + 1] != 0)
+                {
+                    positions.push_back(first[l]);
+                    component_labels.push_back(l);
+                }
+                first[l + 1] += first[l];
+            }
 
-        size_t last_label = std::numeric_limits<size_t>::max();
-        auto&  labels     = this->template col<0>();
-        for (size_t i = 0; i < labels.size(); ++i)
+            std::vector<size_t> destination(n);
+            for (size_t i = 0; i < n; ++i) destination[i] = first[labels[i]]++;
+            permute(0, destination);
+        }
+        else
         {
-            const auto& l = labels[i];
-            if (last_label != l)
+            auto lt = [](const auto& a, const auto& b) { return get<0>(a) < get<0>(b); };
+            std::stable_sort(this->begin(), this->end(), lt);
+
+            size_t last_label = std::numeric_limits<size_t>::max();
+            for (size_t i = 0; i < n; ++i)
             {
-                last_label = l;
-                positions.push_back(i);
+                const auto& l = labels[i];
+                if (last_label != l)
+                {
+                    last_label = l;
+                    positions.push_back(i);
+                    component_labels.push_back(l);
+                }
             }
         }
-        positions.push_back(this->size());
+        positions.push_back(n);
         num_components_backup = num_components();
+        accumulate_weights();
+    }
+
+    /// same as group_by_label after some rows of component index were given the label, as
+    /// long as it is larger than all other labels and the other rows are grouped by label:
+    /// only the rows from the component onwards are moved.
+    void group_split(size_t index, size_t label)
+    {
+        assert(index < num_components());
+        assert(std::all_of(component_labels.begin(), component_labels.end(), [&](size_t l) {
+            return l < label;
+        }));
+        assert(is_grouped(index, label));
+
+        const auto&  labels = this->template col<0>();
+        const size_t a      = positions[index];
+        const size_t b      = positions[index + 1];
+        const size_t n      = this->size();
+
+        const size_t m = std::count(labels.begin() + a, labels.begin() + b, label);
+        if (m == 0) return;
+        if (m == b - a) return group_by_label(); // the component is dissolved
+
+        std::vector<size_t> destination(n - a);
+        for (size_t i = a, kept = a, moved = n - m; i < n; ++i)
+        {
+            destination[i - a] = labels[i] == label ? moved++ : kept++;
+        }
+        permute(a, destination);
+
+        for (size_t j = index + 1; j < positions.size(); ++j) positions[j] -= m;
+        positions.push_back(n);
+        component_labels.push_back(label);
+        num_components_backup = num_components();
+        accumulate_weights();
+    }
+
+    /// whether the rows of every component carry its label, where the rows of component index
+    /// may carry other_label instead
+    bool is_grouped(size_t index, size_t other_label) const
+    {
+        const auto& labels = this->template col<0>();
+        for (size_t j = 0; j < num_components(); ++j)
+        {
+            for (size_t i = positions[j]; i < positions[j + 1]; ++i)
+            {
+                if (labels[i] != component_labels[j] && (j != index || labels[i] != other_label))
+                    return false;
+            }
+        }
+        return true;
     }
 
     void reserve(size_t n)
@@ -387,6 +542,22 @@ struct PartitionedData : public sd::df::col_store<size_t, itemset_view<S>, size_
         this->data->reserve(n);
     }
 
+    bool is_weighted() const { return data && !data->weights.empty(); }
+    /// how often the row at index occurs in the original data
+    size_t weight(size_t index) const
+    {
+        return is_weighted() ? data->weights[original_position(index)] : 1;
+    }
+    /// number of rows of the original data, counting duplicates
+    size_t num_rows() const { return is_weighted() ? data->num_rows() : this->size(); }
+    /// number of rows of the original data in a component, counting duplicates
+    size_t num_rows(size_t index) const
+    {
+        const auto a = positions[index];
+        const auto b = positions[index + 1];
+        return is_weighted() ? cumulative_weights[b] - cumulative_weights[a] : b - a;
+    }
+
     decltype(auto) point(size_t index) { return this->template col<1>()[index]; }
     decltype(auto) point(size_t index) const { return this->template col<1>()[index]; }
     decltype(auto) label(size_t index) const { return this->template col<0>()[index]; }
@@ -395,27 +566,83 @@ struct PartitionedData : public sd::df::col_store<size_t, itemset_view<S>, size_
     {
         return this->template col<2>()[index];
     }
+    decltype(auto) signature(size_t index) const { return this->template col<3>()[index]; }
+    decltype(auto) signature(size_t index) { return this->template col<3>()[index]; }
+
+    /// identifies the set of rows of a component, independent of their order
+    size_t fingerprint_of_subset(size_t index) const
+    {
+        size_t h = 0;
+        for (size_t i = positions[index]; i < positions[index + 1]; ++i)
+        {
+            size_t z = original_position(i) + 0x9e3779b97f4a7c15;
+            z        = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+            z        = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+            h += z ^ (z >> 31);
+        }
+        return h;
+    }
 
     const auto& underlying_data() const { return *data; }
 
+    /// moves the row at first + i to destination[i]; the rows before first stay
+    void permute(size_t first, const std::vector<size_t>& destination)
+    {
+        this->foreach_col([&](auto& col) {
+            std::decay_t<decltype(col)> rows(col.begin() + first, col.end());
+            for (size_t i = 0; i < rows.size(); ++i) col[destination[i]] = std::move(rows[i]);
+        });
+    }
+
+    void accumulate_weights()
+    {
+        cumulative_weights.clear();
+        if (!is_weighted()) return;
+        cumulative_weights.resize(this->size() + 1);
+        cumulative_weights[0] = 0;
+        for (size_t i = 0; i < this->size(); ++i)
+        {
+            cumulative_weights[i + 1] = cumulative_weights[i] + weight(i);
+        }
+    }
+
 // private:
     std::shared_ptr<Dataset<S>> data;
     std::vector<size_t> positions;
+    // label of the rows of each component when they were grouped; rows can be relabeled later
+    std::vector<size_t> component_labels;
+    std::vector<size_t> cumulative_weights; // of the rows in their current order, if weighted
 
 public:
     size_t dim                   = 0;
     size_t num_components_backup = 0;
 };
 
+/// labels of the rows before deduplicate_rows, given its result. data has to be in its
+/// original order, see PartitionedData::revert_order.
+template <typename S>
+std::vector<size_t> expand_labels(const PartitionedData<S>&  data,
+                                  const std::vector<size_t>& unique_of_row)
+{
+    std::vector<size_t> labels(unique_of_row.size());
+    for (size_t i = 0; i < labels.size(); ++i)
+    {
+        assert(data.original_position(unique_of_row[i]) == unique_of_row[i]);
+        labels[i] = data.label(unique_of_row[i]);
+    }
+    return labels;
+}
+
 template <typename S>
 void simplify_labels(PartitionedData<S>& data)
 {
     for (size_t subset = 0, n = data.num_components(); subset < n; ++subset)
     {
-        for (auto [y, _1, _2] : data.subset(subset))
+        for (auto [y, _1, _2, _3] : data.subset(subset))
         {
             y = subset;
         }
+        data.component_labels[subset] = subset;
     }
 }
 
@@ -6,6 +6,8 @@
 
 // #include <boost/container/small_vector.hpp>
 
+#include <cstdint>
+#include <limits>
 #include <numeric>
 #include <type_traits>
 #include <vector>
@@ -37,6 +39,41 @@ std::size_t size_of_union(const S& s, const T& t)
     return size_of_union(s, count(s), t, count(t));
 }
 
+/// 64-bit folded signature of an itemset: bit (i mod 64) is set for every item i.
+/// x can only be a subset of t if signature(x) & ~signature(t) is zero.
+using signature_type = std::uint64_t;
+
+inline signature_type signature(std::size_t i) { return signature_type(1) << (i & 63); }
+
+template <typename S>
+signature_type signature(const bit_view<S>& s)
+{
+    using block_type             = typename bit_view<S>::block_type;
+    constexpr std::size_t digits = std::numeric_limits<block_type>::digits;
+
+    signature_type h = 0;
+    for (std::size_t k = 0; k < s.container.size(); ++k)
+        h |= signature_type(s.container[k]) << ((k * digits) & 63);
+    return h;
+}
+
+template <typename S>
+signature_type signature(const sparse_bit_view<S>& s)
+{
+    signature_type h = 0;
+    for (auto i : s.container) h |= signature(static_cast<std::size_t>(i));
+    return h;
+}
+
+inline bool maybe_subset(signature_type x, signature_type t) { return (x & ~t) == 0; }
+
+/// is_subset that rejects most negatives by their signatures alone
+template <typename S, typename T>
+bool is_subset(const S& x, signature_type sx, const T& t, signature_type st)
+{
+    return maybe_subset(sx, st) && is_subset(x, t);
+}
+
 // template <typename T, size_t N, typename Alloc = std::allocator<T>>
 // using small_vector = boost::container::small_vector<T, N, Alloc>;
 // llvm_vecsmall::SmallVector<T, N>;
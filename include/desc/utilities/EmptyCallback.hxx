@@ -1,5 +1,9 @@
 #pragma once
 
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
 namespace sd
 {
 
@@ -11,4 +15,41 @@ struct EmptyCallback
     }
 };
 
-} // namespace sd
\ No newline at end of file
+namespace detail
+{
+template <typename F, typename C, typename Extra, size_t... I>
+constexpr bool accepts_extra(std::index_sequence<I...>)
+{
+    return std::is_invocable_v<F, const C&, std::tuple_element_t<I, Extra>...>;
+}
+
+template <typename F, typename C, typename Extra, size_t... I>
+void call_with_extra(F&& f, const C& c, const Extra& extra, std::index_sequence<I...>)
+{
+    f(c, std::get<I>(extra)...);
+}
+
+template <size_t N, typename F, typename C, typename Extra>
+void invoke_callback_with(F&& f, const C& c, const Extra& extra)
+{
+    if constexpr (accepts_extra<F, C, Extra>(std::make_index_sequence<N>{}))
+    {
+        call_with_extra(f, c, extra, std::make_index_sequence<N>{});
+    }
+    else
+    {
+        static_assert(N > 0, "the callback has to accept the component");
+        if constexpr (N > 0) invoke_callback_with<N - 1>(f, c, extra);
+    }
+}
+} // namespace detail
+
+/// calls f(c, extra...) with as many of the extra arguments as f accepts, dropping them from
+/// the back, i.e. f(c) if it accepts none of them
+template <typename F, typename C, typename... Extra>
+void invoke_callback(F&& f, const C& c, const Extra&... extra)
+{
+    detail::invoke_callback_with<sizeof...(Extra)>(f, c, std::tie(extra...));
+}
+
+} // namespace sd
@@ -1,19 +1,108 @@
 #pragma once
 
+#include <desc/distribution/IterativeScaling.hxx>
 #include <desc/distribution/MaxEntFactor.hxx>
 
+#include <algorithm>
+#include <utility>
+#include <vector>
+
 namespace sd::disc
 {
 
+/// adds the candidate with the highest gain until max_factor_size + 1 are added or no gain
+/// is positive. all remaining gains are computed again after every insertion.
+template <typename Gain, typename Insert>
+void select_greedy(size_t n, size_t max_factor_size, Gain&& gain, Insert&& insert)
+{
+    using float_type = decltype(gain(size_t(0)));
+
+    // small_bitset<size_t, 1> in_use;
+    thread_local sd::disc::itemset<sd::disc::tag_dense> in_use;
+    in_use.clear();
+
+    for (size_t count = 0; count <= max_factor_size;)
+    {
+        std::pair best{n, float_type(0)};
+        for (size_t j = n; j-- > 0;)
+        {
+            if (in_use.test(j)) continue;
+
+            const auto g = gain(j);
+            if (g > best.second) { best = {j, g}; }
+        }
+
+        if (best.first >= n || best.second == 0.0) break;
+
+        ++count;
+        in_use.insert(best.first);
+        insert(best.first);
+    }
+}
+
+/// like select_greedy, but keeps the candidates in a max-heap keyed by the gain computed in
+/// an earlier round and only computes the gain of the top again (celf). this assumes that
+/// gains only shrink as the factor grows. the assignment score is not submodular, so that
+/// does not hold: this is a heuristic with no bound on how far its selection is from the
+/// one of select_greedy.
+template <typename Gain, typename Insert>
+void select_lazy_greedy(size_t n, size_t max_factor_size, Gain&& gain, Insert&& insert)
+{
+    using float_type = decltype(gain(size_t(0)));
+
+    struct candidate
+    {
+        float_type gain;
+        size_t     index;
+        size_t     round;
+
+        bool operator<(const candidate& rhs) const
+        {
+            return gain < rhs.gain || (gain == rhs.gain && index < rhs.index);
+        }
+    };
+
+    thread_local std::vector<candidate> heap;
+    heap.clear();
+    for (size_t j = 0; j < n; ++j) { heap.push_back({gain(j), j, 0}); }
+    std::make_heap(heap.begin(), heap.end());
+
+    for (size_t count = 0; count <= max_factor_size && !heap.empty();)
+    {
+        std::pop_heap(heap.begin(), heap.end());
+        auto& top = heap.back();
+
+        if (top.round != count)
+        {
+            top.gain  = gain(top.index);
+            top.round = count;
+            std::push_heap(heap.begin(), heap.end());
+            continue;
+        }
+
+        if (!(top.gain > 0)) break;
+
+        ++count;
+        insert(top.index);
+        heap.pop_back();
+    }
+}
+
 template <typename factor_type>
-void prune_factor(factor_type& next, size_t max_factor_size)
+void prune_factor(factor_type&              next,
+                  size_t                    max_factor_size,
+                  ScalingStatisticsCounter* statistics = nullptr,
+                  bool                      lazy       = false)
 {
-    using float_type = std::decay_t<decltype(next.factor.singletons.set.front().frequency)>;
+    using float_type = typename decltype(next.factor)::float_type;
     using std::log2, std::abs;
 
-    if (next.factor.itemsets.set.size() == 0)
+    IterativeScalingSettings<float_type> opts;
+    opts.statistics = statistics;
+
+    if (next.factor.itemsets.size() == 0)
     {
-        estimate_model(next.factor);
+        estimate_model(next.factor, opts);
         return;
     }
 
@@ -22,47 +111,29 @@ void prune_factor(factor_type& next, size_t max_factor_size)
     replacement.factor.itemsets.num_singletons = replacement.factor.singletons.size();
     replacement.range.insert(next.range);
 
-    estimate_model(replacement.factor);
-
-    auto& xs = next.factor.itemsets.set;
-
-    // small_bitset<size_t, 1> in_use;
-    thread_local sd::disc::itemset<sd::disc::tag_dense> in_use; in_use.clear();
-
-    for (size_t count = 0, n = xs.size(); count <= max_factor_size;)
-    {
-        std::pair best{n, float_type(0)};
-        for (size_t j = n; j-- > 0;)
-        {
-            if (in_use.test(j))
-                continue;
+    estimate_model(replacement.factor, opts);
 
-            auto p = expectation(replacement.factor, xs[j].point);
-            auto q = xs[j].frequency;
-            auto g = abs(q * log2(q / p)) + abs(p * log2(p / q)); // assignment_score
+    const auto& xs = next.factor.itemsets;
 
-            if (g > best.second)
-            {
-                best = {j, g};
-            }
-        }
+    opts.warmstart = true;
 
-        if (best.first >= n)
-            break;
+    const auto gain = [&](size_t j) {
+        auto p = expectation(replacement.factor, xs.point(j));
+        auto q = xs.frequency(j);
+        return abs(q * log2(q / p)) + abs(p * log2(p / q)); // assignment_score
+    };
+    const auto insert = [&](size_t j) {
+        insert_and_estimate(replacement.factor, xs.frequency(j), xs.point(j), opts);
+    };
 
-        if (best.second != 0.0)
-        {
-            ++count;
-            in_use.insert(best.first);
-            replacement.factor.insert(xs[best.first].frequency, xs[best.first].point, true);
-        }
-        else
-        {
-            break;
-        }
+    if (lazy) { select_lazy_greedy(xs.size(), max_factor_size, gain, insert); }
+    else
+    {
+        select_greedy(xs.size(), max_factor_size, gain, insert);
     }
+
     next = std::move(replacement);
-    // assert(next.factor.itemsets.set.size() > 0);
+    // assert(next.factor.itemsets.size() > 0);
 }
 
-} // namespace sd::disc
\ No newline at end of file
+} // namespace sd::disc
@@ -20,8 +20,8 @@ void clear_unused_factors(const std::vector<size_t>& u, Factors& facs)
     {
         if (u[i] == 0 && !is_singleton(facs[i].range))
         {
-            facs[i].factor.itemsets.set.clear();
-            facs[i].factor.singletons.set.clear();
+            facs[i].factor.itemsets.clear();
+            facs[i].factor.singletons.clear();
             facs[i].range.clear();
         }
     }
@@ -53,6 +53,8 @@ void prune_unused_factors(Component<Trait>& c)
     std::vector<size_t> u;
     calc_factor_usage(u, c.model.model, c.data);
     remove_unused_factors(u, c.model.model.phi.factors);
+    reindex_factors(c.model.model.phi);
+    c.model.touch();
 }
 
 template <typename Trait>
@@ -63,34 +65,71 @@ void prune_unused_factors(Composition<Trait>& c)
     {
         calc_factor_usage(u, m.model, c.data);
         remove_unused_factors(u, m.model.phi.factors);
+        reindex_factors(m.model.phi);
+        m.touch();
     }
 }
 
 template <typename U>
-void prune_individual_factors(std::vector<Factor<U>>& phi, size_t max_factor_size)
+void prune_individual_factors(std::vector<Factor<U>*>&  phi,
+                              size_t                    max_factor_size,
+                              ScalingStatisticsCounter* statistics = nullptr,
+                              bool                      lazy       = false)
 {
+    // factors differ a lot in size, hence the dynamic schedule
 #if defined(HAS_EXECUTION_POLICIES)
-    std::for_each(std::execution::par_unseq, phi.begin(), phi.end(), [&](auto& phi_i) {
-        if (phi_i.factor.itemsets.set.size() > 2) prune_factor(phi_i, max_factor_size);
+    std::for_each(std::execution::par_unseq, phi.begin(), phi.end(), [&](auto* phi_i) {
+        if (phi_i->factor.itemsets.size() > 2)
+            prune_factor(*phi_i, max_factor_size, statistics, lazy);
     });
 #else
-#pragma omp parallel for if (phi.size() > 16)
+#pragma omp parallel for schedule(dynamic, 1)
     for (size_t i = 0; i < phi.size(); ++i)
     {
-        if (phi[i].factor.itemsets.set.size() > 2) { prune_factor(phi[i], max_factor_size); }
+        if (phi[i]->factor.itemsets.size() > 2)
+        {
+            prune_factor(*phi[i], max_factor_size, statistics, lazy);
+        }
     }
 #endif
 }
 
+template <typename U>
+void collect_prunable_factors(std::vector<Factor<U>>& phi, std::vector<Factor<U>*>& out)
+{
+    for (auto& f : phi)
+    {
+        if (f.factor.itemsets.size() > 2) out.push_back(&f);
+    }
+}
+
+template <typename U>
+void prune_individual_factors(std::vector<Factor<U>>&   phi,
+                              size_t                    max_factor_size,
+                              ScalingStatisticsCounter* statistics = nullptr,
+                              bool                      lazy       = false)
+{
+    std::vector<Factor<U>*> todo;
+    collect_prunable_factors(phi, todo);
+    prune_individual_factors(todo, max_factor_size, statistics, lazy);
+}
+
 template <typename Trait>
-void prune_individual_factors(Component<Trait>& c, size_t max_factor_size)
+void prune_individual_factors(Component<Trait>& c, size_t max_factor_size, bool lazy = false)
 {
-    prune_individual_factors(c.model.model.phi.factors, max_factor_size);
+    prune_individual_factors(
+        c.model.model.phi.factors, max_factor_size, c.scaling_statistics.get(), lazy);
+    c.model.touch();
 }
 template <typename Trait>
-void prune_individual_factors(Composition<Trait>& c, size_t max_factor_size)
+void prune_individual_factors(Composition<Trait>& c, size_t max_factor_size, bool lazy = false)
 {
-    for (auto& m : c.models) prune_individual_factors(m.model.phi.factors, max_factor_size);
+    // one parallel pass over the factors of all components
+    using factor_type = typename Trait::distribution_type::underlying_model_type::factor_type;
+    std::vector<factor_type*> todo;
+    for (auto& m : c.models) collect_prunable_factors(m.model.phi.factors, todo);
+    prune_individual_factors(todo, max_factor_size, c.scaling_statistics.get(), lazy);
+    for (auto& m : c.models) m.touch();
 }
 
 template <class T>
@@ -230,14 +269,14 @@ void prune_composition_mk1(C& c, const Config& cfg, Confidence&& f)
     if constexpr (is_dynamic_factor_model<dist_t>())
     {
         prune_unused_factors(c);
-        prune_individual_factors(c, cfg.max_factor_size);
+        prune_individual_factors(c, cfg.max_factor_size, cfg.lazy_factor_pruning);
         prune_unused_patterns(c);
         assign_from_factors(c);
     }
     else
     {
         size_t before = c.summary.size();
-        prune_individual_factors(c, cfg.max_factor_size);
+        prune_individual_factors(c, cfg.max_factor_size, cfg.lazy_factor_pruning);
         prune_unused_patterns(c);
         characterize_components(c, cfg, f);
         size_t after = c.summary.size();
@@ -252,7 +291,7 @@ void prune_composition(C& c, const Config& cfg, Confidence&& f)
     if constexpr (is_dynamic_factor_model<dist_t>()) { prune_unused_factors(c); }
 
     size_t before = c.summary.size();
-    prune_individual_factors(c, cfg.max_factor_size);
+    prune_individual_factors(c, cfg.max_factor_size, cfg.lazy_factor_pruning);
     prune_unused_patterns(c);
     characterize_components(c, cfg, f);
     size_t after = c.summary.size();
@@ -24,7 +24,7 @@ auto encode_model_bic_aaai20(const Composition<Trait>& c) -> typename Trait::flo
 
     using std::log2;
 
-    const auto n = c.data.size();
+    const auto n = c.data.num_rows();
     const auto s = c.summary.size();
     const auto k = c.data.num_components();
     const auto d = c.data.dim;
@@ -39,7 +39,7 @@ auto encode_model_bic_aaai20(const Composition<Trait>& c) -> typename Trait::flo
 template <typename Trait>
 auto encode_model_bic_new(const Composition<Trait>& c)
 {
-    const auto n  = c.data.size();
+    const auto n  = c.data.num_rows();
     const auto k  = c.data.num_components();
     const auto d  = c.data.dim;
     const auto s  = c.summary.size();
@@ -61,14 +61,14 @@ auto encode_model_bic(const Composition<Trait>& c) -> typename Trait::float_type
     using std::log2;
     const auto k = c.data.num_components();
     const auto m = c.summary.size() - c.data.dim;
-    return log2(c.data.size()) * m * k / 2;
+    return log2(c.data.num_rows()) * m * k / 2;
 }
 
 template <typename Trait>
 auto encode_model_bic(const Component<Trait>& c)
 {
     using std::log2;
-    return log2(c.data.size()) * (c.summary.size() - c.data.dim) / 2.;
+    return log2(c.data.num_rows()) * (c.summary.size() - c.data.dim) / 2.;
 }
 
 } // namespace sd::disc::bic
\ No newline at end of file
@@ -23,7 +23,7 @@ void resize_after_split(Composition<Trait>&       c,
     using float_type = typename Trait::float_type;
 
     c.assignment.resize(c.data.num_components());
-    c.models.resize(c.data.num_components(), make_distribution(c, cfg));
+    c.models.resize(c.data.num_components());
     subset_encodings.resize(c.data.num_components(), 0);
 
     if (c.frequency.size() == 0 || c.data.num_components() == 1 ||
@@ -63,7 +63,7 @@ void update_encoding(const Composition<Trait>& c,
 
     l.of_data -= subset_encodings[index];
 
-    subset_encodings[index] = log_likelihood(c.models[index], c.data.subset(index));
+    subset_encodings[index] = log_likelihood_of_subset(c, index);
 
     l.of_data += subset_encodings[index];
 }
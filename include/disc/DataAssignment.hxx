@@ -4,6 +4,9 @@
 #include <disc/Settings.hxx>
 #include <desc/utilities/EmptyCallback.hxx>
 
+#include <omp.h>
+
+#include <algorithm>
 #include <iterator>
 #include <utility>
 
@@ -20,7 +23,7 @@ void erase_from_composition(const itemset<tag_dense>& tombstone, Container& c)
 
     for (size_t i = 0, j = 0; i < tombstone.length(); ++i)
     {
-        if (tombstone.test(i)) { c.erase(std::next(c.begin(), j)); }
+        if (tombstone.test(i)) { c.erase(std::next(std::as_const(c).begin(), j)); }
         else
         {
             ++j;
@@ -30,29 +33,17 @@ void erase_from_composition(const itemset<tag_dense>& tombstone, Container& c)
     assert(c.size() == expected_size);
 }
 
+/// the rows of a component can be relabeled before they are regrouped, see reassign_rows:
+/// the component ids go by the labels that the rows had when they were grouped
 template <typename Trait>
 auto label_to_component_id(const Composition<Trait>& c)
 {
-    // small_vector<size_t, 64> map(1 + *std::max_element(c.data.template col<0>().begin(),
-
-    // std::vector<size_t> map;
-    // map.reserve(64);
-    // for(size_t i = 0; i < c.data.num_components(); ++i) {
-    //     auto to = label(c.data.subset(i)[0]);
-    //     if (to <= map.size()) map.resize(to + 1);
-    //     map[to] = i;
-    // }
-    size_t largest_label = 0;
-    for (size_t i = 0; i < c.data.num_components(); ++i)
-    {
-        largest_label = std::max(largest_label, label(c.data.subset(i)[0]));
-    }
+    const auto& labels = c.data.component_labels;
+
+    const size_t largest_label =
+        labels.empty() ? 0 : *std::max_element(labels.begin(), labels.end());
     std::vector<size_t> map(1 + largest_label);
-    // small_vector<size_t, 64> map(1 + largest_label);
-    for (size_t i = 0; i < c.data.num_components(); ++i)
-    {
-        map[label(c.data.subset(i)[0])] = i;
-    }
+    for (size_t i = 0; i < labels.size(); ++i) map[labels[i]] = i;
     return map;
 }
 
@@ -69,18 +60,17 @@ auto create_tombstones(Composition<Trait> const& c, const IDs& rev)
     return tombstone;
 }
 
-template <typename Trait, typename IDs>
-size_t remove_empty_components(Composition<Trait>& c, const IDs& rev)
+template <typename Trait>
+size_t remove_empty_components(Composition<Trait>& c, const itemset<tag_dense>& tombstone)
 {
-    auto tombstone = create_tombstones(c, rev);
-
     auto cnt = count(tombstone);
 
     if (cnt == 0) return cnt;
 
     erase_from_composition(tombstone, c.models);
-    // erase_from_composition(tombstone, c.subset_encodings);
     erase_from_composition(tombstone, c.assignment);
+    if (c.characterized.size() == tombstone.length())
+        erase_from_composition(tombstone, c.characterized);
 
     c.data.group_by_label();
     simplify_labels(c.data);
@@ -88,13 +78,68 @@ size_t remove_empty_components(Composition<Trait>& c, const IDs& rev)
     return cnt;
 }
 
+template <typename Trait, typename IDs>
+size_t remove_empty_components(Composition<Trait>& c, const IDs& rev)
+{
+    return remove_empty_components(c, create_tombstones(c, rev));
+}
+
 template <typename S>
 auto get_component_label(const PartitionedData<S>& data)
 {
-    std::vector<size_t> ids(data.num_components());
-    // small_vector<size_t, 32> ids(data.num_components());
-    for (size_t i = 0; i < ids.size(); ++i) { ids[i] = label(data.subset(i)[0]); }
-    return ids;
+    return data.component_labels;
+}
+
+/// makes sure that every model holds the scores of all rows of data, see RowScores: the models
+/// whose scores are missing or outdated score the rows together in one sweep over batches of
+/// rows. not thread-safe: inside a parallel region, call it only on models that no other
+/// copy of the composition holds.
+template <typename Models, typename S>
+void score_all_rows(const Models& models, const PartitionedData<S>& data)
+{
+    using distribution_type = typename Models::value_type;
+    using pattern_type      = typename distribution_type::pattern_type;
+
+    const size_t n   = data.size();
+    const void*  key = &data.underlying_data();
+
+    std::vector<const distribution_type*> todo;
+    for (size_t i = 0; i < models.size(); ++i)
+    {
+        const auto& m = models[i];
+        auto&       s = m.row_scores;
+        if (s.is_valid(m.version, key, n)) continue;
+
+        // inside a parallel region, only the models that no other thread reads are scored
+        assert(!omp_in_parallel() || !models.is_shared(i));
+
+        m.compile_tables(data);
+        s.version = m.version;
+        s.data    = key;
+        s.scores.resize(n);
+        todo.push_back(&m);
+    }
+
+    if (todo.empty()) return;
+
+    const size_t batches = (n + row_batch_size - 1) / row_batch_size;
+
+#pragma omp parallel for schedule(dynamic, 1)
+    for (size_t b = 0; b < batches; ++b)
+    {
+        thread_local TableScratch<pattern_type> buf;
+
+        const size_t end = std::min(n, (b + 1) * row_batch_size);
+        for (size_t r = b * row_batch_size; r < end; ++r)
+        {
+            const auto& x   = data.point(r);
+            const auto  pos = data.original_position(r);
+            for (auto m : todo)
+            {
+                m->row_scores.scores[pos] = disc::log_expectation(m->model, m->tables, x, buf);
+            }
+        }
+    }
 }
 
 template <typename Trait>
@@ -125,21 +170,29 @@ auto reassign_rows(Composition<Trait>& c)
     //                    }
     //                })
 
-#pragma omp parallel for
-    for (size_t k = 0; k < c.data.size(); ++k)
+    const size_t n = c.data.size();
+    const size_t k = c.data.num_components();
+
+    const auto& models = std::as_const(c).models;
+    score_all_rows(models, c.data);
+
+#pragma omp parallel for reduction(+ : count)
+    for (size_t r = 0; r < n; ++r)
     {
-        std::pair<size_t, float_type> best = {0, -1};
+        const auto pos = c.data.original_position(r);
+
+        std::pair<size_t, float_type> best = {0, models[0].row_scores.scores[pos]};
 
-        for (size_t i = 0; i < c.data.num_components(); ++i)
+        for (size_t i = 1; i < k; ++i)
         {
-            const auto p = c.models[i].expectation(c.data.point(k));
+            const auto p = models[i].row_scores.scores[pos];
 
             if (best.second < p) best = {i, p};
         }
 
-        count += c.data.label(k) != ids[best.first];
+        count += c.data.label(r) != ids[best.first];
 
-        c.data.label(k) = ids[best.first];
+        c.data.label(r) = ids[best.first];
     }
 
     return count;
@@ -184,6 +237,22 @@ auto reassign_rows(Composition<Trait>& c)
 // }
 
 
+/// one round of reassign_components. returns false if no row moved; otherwise removed holds
+/// the components that ran empty and were removed, by their index before the round.
+template <typename Trait, typename Interface = DefaultAssignment>
+bool reassign_components_once(Composition<Trait>& c,
+                              const Config&       cfg,
+                              itemset<tag_dense>& removed,
+                              Interface&&         f = {})
+{
+    auto r = label_to_component_id(c);
+    if (reassign_rows(c) == 0) return false;
+    removed = create_tombstones(c, r);
+    remove_empty_components(c, removed);
+    characterize_components(c, cfg, f);
+    return true;
+}
+
 template <typename Trait, typename Interface = DefaultAssignment>
 void reassign_components(Composition<Trait>& c,
                           const Config&   cfg,
@@ -191,12 +260,10 @@ void reassign_components(Composition<Trait>& c,
                           Interface&&         f             = {})
 {
     assert(check_invariant(c));
+    itemset<tag_dense> removed;
     while (c.data.num_components() > 1 && max_iteration-- > 0)
     {
-        auto r = label_to_component_id(c);
-        if (reassign_rows(c) == 0) break;
-        remove_empty_components(c, r);
-        characterize_components(c, cfg, f);
+        if (!reassign_components_once(c, cfg, removed, f)) break;
         assert(check_invariant(c));
     }
 }
@@ -5,9 +5,13 @@
 #include <disc/CharacterizeSplit.hxx>
 #include <disc/DataAssignment.hxx>
 #include <disc/Settings.hxx>
+#include <disc/SplitScreening.hxx>
 #include <disc/TestDivergence.hxx>
 #include <container/random-access-set.hxx>
 
+#include <algorithm>
+#include <tuple>
+
 namespace sd
 {
 namespace disc
@@ -16,27 +20,29 @@ namespace disc
 template <typename Trait, typename P>
 void split_data(Composition<Trait>& com, const P& x, size_t label)
 {
-    for (auto [y, t, _] : com.data)
+    const auto sx = signature(x);
+    for (auto [y, t, _, st] : com.data)
     {
-        if (is_subset(x, t)) y = label;
+        if (is_subset(x, sx, t, st)) y = label;
     }
     com.data.group_by_label();
 }
 template <typename Trait, typename P>
 void split_component(Composition<Trait>& com, size_t index, const P& x, size_t label)
 {
-    for (auto [y, t, _] : com.data.subset(index))
+    const auto sx = signature(x);
+    for (auto [y, t, _, st] : com.data.subset(index))
     {
-        if (is_subset(x, t)) y = label;
+        if (is_subset(x, sx, t, st)) y = label;
     }
-    com.data.group_by_label();
+    com.data.group_split(index, label);
 }
 /*
 template <typename Trait, typename P>
 void just_split(Composition<Trait>& com, const P& x, size_t index, size_t label)
 {
     auto set = com.data.subset(index);
-    for (auto [y, t, _] : set)
+    for (auto [y, t, _, st] : set)
     {
         if (is_subset(x, t)) y = label;
     }
@@ -46,7 +52,7 @@ void just_split(Composition<Trait>& com, const P& x, size_t index, size_t label)
 template <typename Trait>
 void undo_split_data(Composition<Trait>& com, size_t label_before, size_t label_after)
 {
-    for (auto [y, t, _] : com.data)
+    for (auto [y, t, _, st] : com.data)
     {
         if (y == label_before) y = label_after;
     }
@@ -196,7 +202,7 @@ bool is_early_reject(const Composition<Trait>& com,
 
     const auto q_i   = com.frequency(pattern_index, comp_index);
     const auto q     = com.frequency(pattern_index, com.frequency.extent(1) - 1);
-    const auto minfr = float_type(cfg.min_support) / com.data.size();
+    const auto minfr = float_type(cfg.min_support) / com.data.num_rows();
 
     if (q_i < minfr || (float_type(1) - q_i) < minfr || q < minfr) { return true; }
     else
@@ -205,12 +211,52 @@ bool is_early_reject(const Composition<Trait>& com,
     }
 }
 
+/// a split that did not improve the encoding. it is identified by the rows of the component,
+/// the summary its model is characterized from, and the pattern, so that it stays valid when
+/// components and patterns are renumbered, and no longer matches once the rows or the model
+/// change.
+struct RejectedSplit
+{
+    size_t rows    = 0;
+    size_t summary = 0;
+    size_t pattern = 0;
+
+    friend bool operator<(const RejectedSplit& a, const RejectedSplit& b)
+    {
+        return std::tie(a.rows, a.summary, a.pattern) < std::tie(b.rows, b.summary, b.pattern);
+    }
+};
+
+using RejectedSplits = andres::RandomAccessSet<RejectedSplit>;
+
+/// drops the rejected splits that no longer match, because their rows are no component or
+/// the summary has changed. components holds the key of every component, without a pattern.
+inline void prune_rejected_splits(const std::vector<RejectedSplit>& components,
+                                  size_t                            summary,
+                                  RejectedSplits&                   rejected)
+{
+    std::vector<size_t> rows;
+    rows.reserve(components.size());
+    for (const auto& k : components) rows.push_back(k.rows);
+    std::sort(rows.begin(), rows.end());
+
+    RejectedSplits kept;
+    kept.reserve(rejected.size());
+    for (const auto& r : rejected)
+    {
+        if (r.summary == summary && std::binary_search(rows.begin(), rows.end(), r.rows))
+            kept.insert(kept.end(), r);
+    }
+    rejected = std::move(kept);
+}
+
 template <typename Trait, typename Interface = DefaultAssignment>
-bool disc_decomp_step(Composition<Trait>&                                 c,
-                      const DiscConfig&                                   cfg,
-                      EncodingLength<typename Trait::float_type>&         encoding,
-                      andres::RandomAccessSet<std::pair<size_t, size_t>>& rejected,
-                      Interface&&                                         f = {})
+bool disc_decomp_step(Composition<Trait>&                         c,
+                      const DiscConfig&                           cfg,
+                      EncodingLength<typename Trait::float_type>& encoding,
+                      RejectedSplits&                             rejected,
+                      SplitScreeningStatistics&                   screening_statistics,
+                      Interface&&                                 f = {})
 {
 
     using float_type = typename Trait::float_type;
@@ -218,35 +264,73 @@ bool disc_decomp_step(Composition<Trait>&                                 c,
     auto best          = c;
     auto best_encoding = encoding;
 
-    std::atomic_int label       = c.data.num_components() + 1;
-    float_type      calpha      = cfg.alpha / (c.data.num_components() * c.summary.size());
-    const auto      rejected_ro = rejected;
+    std::atomic_int label  = c.data.num_components() + 1;
+    float_type      calpha = cfg.alpha / (c.data.num_components() * c.summary.size());
+
+    DiscConfig scoring_cfg = cfg;
+    static_cast<Config&>(scoring_cfg) = scoring_config(cfg);
+
+    // the candidates share the models of c until they change them: compile their tables and
+    // score all rows now, so that the candidates only read the shared models.
+    score_all_rows(std::as_const(c).models, c.data);
+
+    const auto screening = prepare_split_screening(c);
+
+    const size_t               summary = fingerprint_of_summary(c.summary);
+    std::vector<RejectedSplit> components(c.data.num_components());
+    std::vector<size_t>        patterns(c.summary.size());
+    for (size_t i = 0; i < components.size(); ++i)
+        components[i] = {c.data.fingerprint_of_subset(i), summary, 0};
+    for (size_t j = 0; j < patterns.size(); ++j) patterns[j] = fingerprint(c.summary.point(j));
+
+    // the candidates read rejected, and the splits that they reject are added after the loop
+    prune_rejected_splits(components, summary, rejected);
+    std::vector<RejectedSplit> newly_rejected;
+
+    const auto split_of = [&](size_t i, size_t j) {
+        auto key    = components[i];
+        key.pattern = patterns[j];
+        return key;
+    };
+
+    size_t screened = 0, passed = 0;
+
+    // the pattern of the best significant split of every component, for cfg.multi_split
+    const size_t            no_split = c.summary.size();
+    std::vector<size_t>     split_pattern(c.data.num_components(), no_split);
+    std::vector<float_type> split_objective(c.data.num_components(), encoding.objective());
 
 #pragma omp parallel for collapse(2) schedule(dynamic, 1) shared(best) shared(rejected)        \
-    firstprivate(rejected_ro)
+    shared(newly_rejected) reduction(+ : screened, passed)
     for (size_t i = 0; i < c.data.num_components(); ++i)
     {
         for (size_t j = 0; j < c.summary.size(); ++j)
         {
             // !c.assignment[i].contains(j) &&
             if (c.confidence(j, i) <= 0 || is_early_reject(c, j, i, cfg) ||
-                rejected_ro.find({i, j}) != rejected_ro.end())
+                rejected.find(split_of(i, j)) != rejected.end())
             {
                 continue;
             }
 
-            auto next = c; // expensive
+            // a split that fails the divergence test below is discarded before it is copied
+            // and characterized: the frequencies of its two components follow from the rows.
+            ++screened;
+            if (!screen_split(c, screening, i, j, calpha)) { continue; }
+            ++passed;
+
+            auto next = c; // shares the models of c until they change
 
             const auto& x = c.summary.point(j);
             split_component(next, i, x, label++);
             if (next.data.num_components() <= c.data.num_components()) { continue; }
-            characterize_components(next, cfg, f);
+            characterize_components(next, scoring_cfg, f);
             if (!test_stat_divergence(next, calpha, i, next.data.num_components() - 1, j))
             {
                 continue;
             }
 
-            reassign_components(next, cfg, 2, f);
+            reassign_components(next, scoring_cfg, 2, f);
 
             auto next_encoding = encode(next, cfg.use_bic);
 
@@ -263,6 +347,11 @@ bool disc_decomp_step(Composition<Trait>&                                 c,
             {
 #pragma omp critical
                 {
+                    if (split_objective[i] > next_encoding.objective())
+                    {
+                        split_pattern[i]   = j;
+                        split_objective[i] = next_encoding.objective();
+                    }
                     if (best_encoding.objective() > next_encoding.objective())
                     {
                         best          = std::move(next);
@@ -274,14 +363,99 @@ bool disc_decomp_step(Composition<Trait>&                                 c,
             {
 #pragma omp critical
                 {
-                    rejected.insert({i, j});
+                    newly_rejected.push_back(split_of(i, j));
                 }
             }
         }
     }
 
+    screening_statistics += {screened, passed};
+    for (const auto& r : newly_rejected) rejected.insert(r);
+
+    // the pattern of every component that has a significant split
+    std::vector<std::pair<size_t, size_t>> candidates;
+    for (size_t i = 0; i < split_pattern.size(); ++i)
+    {
+        if (split_pattern[i] != no_split) candidates.emplace_back(i, split_pattern[i]);
+    }
+
+    // like a single split, every split has to pass the divergence test before and after the
+    // rows are reassigned. the splits that fail are dropped, and the others are tried again.
+    while (cfg.multi_split && candidates.size() > 1)
+    {
+        auto next = c;
+
+        // the component, its new half and the pattern of every split. the new components
+        // are appended, so the indices of the others are unchanged.
+        std::vector<std::tuple<size_t, size_t, size_t>> splits;
+        for (const auto& [i, j] : candidates)
+        {
+            split_component(next, i, c.summary.point(j), label++);
+            splits.emplace_back(i, next.data.num_components() - 1, j);
+        }
+        if (next.data.num_components() != c.data.num_components() + splits.size()) break;
+
+        const auto drop_failing = [&] {
+            itemset<tag_dense> failing(splits.size(), false);
+            for (size_t s = 0; s < splits.size(); ++s)
+            {
+                const auto [i, k, j] = splits[s];
+                if (!test_stat_divergence(next, calpha, i, k, j)) failing.insert(s);
+            }
+            erase_from_composition(failing, candidates);
+            return !failing.empty();
+        };
+
+        characterize_components(next, scoring_cfg, f);
+        if (drop_failing()) continue;
+
+        // all splits are verified together with a single reassignment and encoding. a split
+        // whose component or new half runs empty fails, the others are renumbered.
+        itemset<tag_dense> removed;
+        if (reassign_components_once(next, scoring_cfg, removed, f) && !removed.empty())
+        {
+            itemset<tag_dense> failing(splits.size(), false);
+            const auto         renumber = [&](size_t index) {
+                size_t below = 0;
+                foreach (removed, [&](size_t r) { below += r < index; })
+                    ;
+                return index - below;
+            };
+            for (size_t s = 0; s < splits.size(); ++s)
+            {
+                auto& [i, k, j] = splits[s];
+                if (removed.test(i) || removed.test(k))
+                    failing.insert(s);
+                else
+                    std::tie(i, k) = std::pair{renumber(i), renumber(k)};
+            }
+            erase_from_composition(failing, splits);
+            erase_from_composition(failing, candidates);
+            if (!failing.empty()) continue;
+        }
+
+        auto next_encoding = encode(next, cfg.use_bic);
+        if (drop_failing()) continue;
+
+        if (best_encoding.objective() > next_encoding.objective())
+        {
+            best          = std::move(next);
+            best_encoding = next_encoding;
+        }
+        break;
+    }
+
     bool is_better = best_encoding.objective() < encoding.objective();
 
+    if (is_better && cfg.adaptive_tolerance)
+    {
+        // best was only scored: solve the components that were solved to the scoring
+        // sensitivity again and compare what is then actually accepted
+        characterize_components(best, cfg, f);
+        best_encoding = encode(best, cfg.use_bic);
+        is_better     = best_encoding.objective() < encoding.objective();
+    }
+
     if (is_better)
     {
         simplify_labels(best.data);
@@ -298,10 +472,17 @@ auto disc_decomp(Composition<Trait>& c,
                  Info&&              info = {},
                  Interface&&         f    = {})
 {
-    andres::RandomAccessSet<std::pair<size_t, size_t>> rejected;
+    RejectedSplits rejected;
     EncodingLength<typename Trait::float_type> encoding;
 
-    while (disc_decomp_step(c, cfg, encoding, rejected, f)) { info(std::as_const(c)); }
+    const auto               scaling        = c.scaling_statistics;
+    const auto               scaling_before = scaling->load();
+    SplitScreeningStatistics screening;
+
+    while (disc_decomp_step(c, cfg, encoding, rejected, screening, f))
+    {
+        invoke_callback(info, std::as_const(c), scaling->load() - scaling_before, screening);
+    }
 
     return encoding;
 }
@@ -321,19 +502,24 @@ auto discover_components(Composition<Trait>& c,
     const auto& tt = cfg.max_time;
     const auto  st = clk::now();
 
+    const auto               scaling        = c.scaling_statistics;
+    const auto               scaling_before = scaling->load();
+    SplitScreeningStatistics screening;
+
     patternset_miner(c, cfg);
     auto encoding = encode(c, cfg.use_bic);
 
-    andres::RandomAccessSet<std::pair<size_t, size_t>> rejected;
+    RejectedSplits rejected;
 
     while (true)
     {
         const size_t k_before = c.data.num_components();
         const size_t s_before = c.summary.size();
 
-        while (disc_decomp_step(c, cfg, encoding, rejected, f))
+        while (disc_decomp_step(c, cfg, encoding, rejected, screening, f))
         {
-            report(std::as_const(c));
+            invoke_callback(
+                report, std::as_const(c), scaling->load() - scaling_before, screening);
 
             if (tt && clk::now() > st + *tt) return encoding;
         }
@@ -4,10 +4,12 @@
 #include <desc/Composition.hxx>
 #include <disc/BIC.hxx>
 #include <disc/MDL.hxx>
+#include <math/Summation.hxx>
 
-#if WITH_EXECUTION_POLICIES
-#include <execution>
-#endif
+#include <omp.h>
+
+#include <algorithm>
+#include <vector>
 
 namespace sd::disc
 {
@@ -19,47 +21,96 @@ auto log_likelihood(Distribution_Type const& model, const Data_Type& data)
 
     assert(!data.empty());
 
-#if WITH_EXECUTION_POLICIES
-    return std::reduce(
-        std::execution::par_unseq,
-        data.begin(),
-        data.end(),
-        float_t(),
-        [&](auto acc, const auto& x) { return acc - model.log_expectation(point(x)); });
-#else
-    // resillience against unlikely numeric issues using laplace smoothing
-    // const auto l = std::min<float_t>(1e-10, float_t(1) / (model.model.dim + data.size()));
-    // const auto l = float_t(1) / (model.model.dim + data.size());
-    float_t acc = 0;
-#pragma omp parallel for reduction(+ : acc)
-    for (size_t i = 0; i < data.size(); ++i)
+    // the terms are computed in parallel, but summed in a fixed order and compensated:
+    // the result neither depends on the number of threads nor loses the small terms.
+    thread_local std::vector<float_t> buffer;
+    auto&                             terms = buffer;
+    terms.resize(data.size());
+
+    score_rows(model, data.begin(), data.end(), terms.begin());
+
+    return -compensated_sum(terms.begin(), terms.end());
+}
+
+/// same as log_likelihood(model, data), but the r-th row of data counts weight(r) times
+template <typename Distribution_Type, typename Data_Type, typename Weight>
+auto log_likelihood(Distribution_Type const& model, const Data_Type& data, Weight&& weight)
+{
+    using float_t = typename Distribution_Type::float_type;
+
+    assert(!data.empty());
+
+    thread_local std::vector<float_t> buffer;
+    auto&                             terms = buffer;
+    terms.resize(data.size());
+
+    score_rows(model, data.begin(), data.end(), terms.begin());
+    for (size_t r = 0; r < terms.size(); ++r) terms[r] *= weight(r);
+
+    return -compensated_sum(terms.begin(), terms.end());
+}
+
+/// reads the scores that score_all_rows left in the model, as long as they are valid. the
+/// terms and their order are the same as those of log_likelihood.
+template <typename Trait>
+auto log_likelihood_of_subset(const Composition<Trait>& c, size_t index)
+{
+    using float_t = typename Trait::float_type;
+
+    const auto& m     = c.models[index];
+    const auto  first = c.data.positions[index];
+    const auto  last  = c.data.positions[index + 1];
+
+    if (!m.row_scores.is_valid(m.version, &c.data.underlying_data(), c.data.size()))
+    {
+        // scoring compiles the tables of the model
+        assert(!omp_in_parallel() || !c.models.is_shared(index));
+
+        if (!c.data.is_weighted()) return log_likelihood(m, c.data.subset(index));
+        return log_likelihood(m, c.data.subset(index), [&](size_t r) {
+            return c.data.weight(first + r);
+        });
+    }
+
+    thread_local std::vector<float_t> buffer;
+    auto&                             terms = buffer;
+    terms.resize(last - first);
+
+    const auto& scores = m.row_scores.scores;
+    for (size_t r = first; r < last; ++r)
     {
-        // auto p = model.expectation(point(data[i]));
-        // if (!(p > 0) || !(p <= 1))
-        // {
-        //     p = std::clamp(p, l, 1 - l);
-        // }
-        acc -= model.log_expectation(point(data[i]));
+        terms[r - first] = scores[c.data.original_position(r)];
+        if (c.data.is_weighted()) terms[r - first] *= c.data.weight(r);
     }
-    return acc;
-#endif
+
+    return -compensated_sum(terms.begin(), terms.end());
 }
 
 template <typename Trait>
 auto encode_data(const Composition<Trait>& c)
 {
     using float_type = typename Trait::float_type;
-    float_type l     = 0;
+    // components whose rows and model are unchanged since the last call are not re-encoded
+    c.subset_encodings.resize(c.models.size());
+
+    CompensatedSum<float_type> l;
     for (size_t i = 0; i < c.models.size(); ++i)
     {
-        l += log_likelihood(c.models[i], c.data.subset(i));
+        auto&      e    = c.subset_encodings[i];
+        const auto rows = c.data.fingerprint_of_subset(i);
+        if (e.version != c.models[i].version || e.rows != rows)
+        {
+            e = {rows, c.models[i].version, log_likelihood_of_subset(c, i)};
+        }
+        l += e.of_data;
     }
-    return l;
+    return l.value();
 }
 template <typename Trait>
 auto encode_data(const Component<Trait>& c)
 {
-    return log_likelihood(c.model, c.data);
+    if (c.data.weights.empty()) return log_likelihood(c.model, c.data);
+    return log_likelihood(c.model, c.data, [&](size_t r) { return c.data.weight(r); });
 }
 
 template <typename C>
@@ -59,13 +59,13 @@ template <typename S>
 double encode_which_rows_per_component(const S& data)
 {
     size_t k = data.num_components();
-    size_t n = data.size();
+    size_t n = data.num_rows();
     if (k == 1) return 0;
 
     double l = 0;
     for (size_t i = 0; i < k; ++i)
     {
-        auto n_i = data.subset(i).size();
+        auto n_i = data.num_rows(i);
         if (n_i == 0) continue;
 
         using std::log2;
@@ -115,18 +115,47 @@ auto encode_summaries_expensive(const Composition<Trait>& c)
 {
     using std::log2;
     using float_type = typename Trait::float_type;
-    float_type acc   = 0;
+
+    // the cost of a pattern only changes with the rows of its component, the pattern itself,
+    // its frequency and the frequencies of its items: everything else is reused.
+    c.subset_model_costs.resize(c.assignment.size());
+
+    float_type acc = 0;
     for (size_t i = 0; i < c.assignment.size(); ++i)
     {
-        const auto n_i = c.data.subset(i).size();
+        auto&      e   = c.subset_model_costs[i];
+        const auto n_i = c.data.num_rows(i);
+
+        size_t rows = c.data.fingerprint_of_subset(i);
+        for (size_t j = 0; j < c.data.dim; ++j)
+        {
+            rows = (rows * 0x100000001b3) ^ std::hash<double>{}(double(c.frequency(j, i)));
+        }
+        if (e.rows != rows)
+        {
+            e.rows = rows;
+            e.patterns.clear();
+        }
+        e.patterns.resize(c.summary.size(), 0);
+        e.frequencies.resize(c.summary.size());
+        e.of_pattern.resize(c.summary.size());
+
         acc += log2(c.assignment[i].size()) * log2(n_i);
         for (auto j : c.assignment[i])
         {
-            size_t      supp = c.frequency(j, i) * n_i;
-            const auto& x    = c.summary.point(j);
-            auto [e, l]      = encode_pattern_by_singletons<float_type>(x, n_i, i, c.frequency);
-
-            acc += e + log2(l) + log2(supp + (supp == 0));
+            const auto& x  = c.summary.point(j);
+            const auto  h  = fingerprint(x);
+            const auto  fr = c.frequency(j, i);
+            if (e.patterns[j] != h || e.frequencies[j] != fr)
+            {
+                size_t supp = static_cast<size_t>(fr * n_i);
+                auto [l, len] = encode_pattern_by_singletons<float_type>(x, n_i, i, c.frequency);
+
+                e.patterns[j]    = h;
+                e.frequencies[j] = fr;
+                e.of_pattern[j]  = l + log2(len) + log2(supp + (supp == 0));
+            }
+            acc += e.of_pattern[j];
         }
     }
     return acc;
@@ -140,7 +169,7 @@ auto encode_per_component_supports(const Composition<Trait>& c)
     {
         assert(c.assignment[i].size() >= c.data.dim);
 
-        const auto n_i = c.data.subset(i).size();
+        const auto n_i = c.data.num_rows(i);
         acc += universal_code(c.assignment[i].size()); // how many patterns
         for (auto j : c.assignment[i])
         {
@@ -198,12 +227,12 @@ auto encode_model_mdl(const Composition<Trait>& c)
 #if 1
     lm += encode_summaries_expensive(c);
     lm += encode_num_component(c.data.num_components());
-    lm += encode_rows_per_component(c.data.size(), c.data.num_components());
+    lm += encode_rows_per_component(c.data.num_rows(), c.data.num_components());
 #else
     lm += encode_num_component(c.data.num_components());
-    lm += encode_rows_per_component(c.data.size(), c.data.num_components());
+    lm += encode_rows_per_component(c.data.num_rows(), c.data.num_components());
 
-    lm += encode_patterns_once_globally(c.summary, c.data.size());
+    lm += encode_patterns_once_globally(c.summary, c.data.num_rows());
     lm +=
         encode_assignment_matrix_without_singletons(c.assignment, c.summary.size(), c.data.dim);
     // lm += encode_per_component_supports(c);
@@ -226,10 +255,10 @@ auto encode_model_mdl(const Composition<Trait>& c)
 template <typename Trait>
 auto encode_model_mdl(const Component<Trait>& c)
 {
-    auto acc = encode_patterns_once_globally(c.summary, c.data.size(), c.frequency);
+    auto acc = encode_patterns_once_globally(c.summary, c.data.num_rows(), c.frequency);
     for (auto fr : c.frequency)
     {
-        acc += universal_code(static_cast<size_t>(fr * c.data.size()));
+        acc += universal_code(static_cast<size_t>(fr * c.data.num_rows()));
     }
     return acc;
 
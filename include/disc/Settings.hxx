@@ -8,6 +8,9 @@ namespace sd::disc
 struct DiscConfig : public Config
 {
     bool use_bic         = true;
+    // also try the best significant split of every component at once, and keep these splits
+    // if they encode better together than the best single split.
+    bool multi_split = false;
 };
 
 } // namespace sd::disc
\ No newline at end of file
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <desc/Composition.hxx>
+#include <desc/Support.hxx>
+#include <disc/TestDivergence.hxx>
+
+#include <vector>
+
+namespace sd::disc
+{
+
+struct SplitScreeningStatistics
+{
+    size_t screened = 0; // candidate splits that were screened
+    size_t passed   = 0; // screened splits that were characterized
+
+    double pass_rate() const { return screened == 0 ? 0 : double(passed) / screened; }
+
+    SplitScreeningStatistics& operator+=(const SplitScreeningStatistics& o)
+    {
+        screened += o.screened;
+        passed += o.passed;
+        return *this;
+    }
+};
+
+/// the rows of every pattern and of every component, in the current order of the rows
+template <typename Trait>
+struct SplitScreening
+{
+    using tid_container = long_storage_container<typename Trait::pattern_type>;
+
+    std::vector<tid_container> rows_of_pattern;
+    std::vector<tid_container> rows_of_component;
+};
+
+template <typename Trait>
+SplitScreening<Trait> prepare_split_screening(const Composition<Trait>& c)
+{
+    using tid_container = typename SplitScreening<Trait>::tid_container;
+
+    SplitScreening<Trait> s;
+    s.rows_of_component = construct_component_masks(c);
+    s.rows_of_pattern.resize(c.summary.size(), tid_container{c.data.size()});
+
+    std::vector<signature_type> sigs;
+    compute_signatures(c.summary, sigs);
+
+#pragma omp parallel for schedule(dynamic, 1)
+    for (size_t j = 0; j < c.summary.size(); ++j)
+    {
+        auto&       rows = s.rows_of_pattern[j];
+        const auto& x    = c.summary.point(j);
+        rows.clear();
+        for (size_t r = 0; r < c.data.size(); ++r)
+        {
+            if (is_subset(x, sigs[j], c.data.point(r), c.data.signature(r))) rows.insert(r);
+        }
+    }
+
+    return s;
+}
+
+template <typename S, typename Rows>
+size_t support_of_rows(const PartitionedData<S>& data, const Rows& rows)
+{
+    if (!data.is_weighted()) return count(rows);
+    size_t s = 0;
+    foreach (rows, [&](size_t r) { s += data.weight(r); })
+        ;
+    return s;
+}
+
+template <typename S, typename Rows>
+size_t support_of_intersection(const PartitionedData<S>& data, const Rows& a, const Rows& b)
+{
+    if (!data.is_weighted()) return size_of_intersection(a, b);
+    thread_local Rows ab;
+    ab.clear();
+    intersection(a, b, ab);
+    return support_of_rows(data, ab);
+}
+
+/// whether splitting component index by the rows that contain pattern x_index passes the
+/// divergence test that disc_decomp_step applies after characterizing the split. the two
+/// frequency columns of the split are counted from the rows of the patterns, and equal the
+/// ones that compute_frequency_matrix computes after split_component.
+template <typename Trait, typename T>
+bool screen_split(const Composition<Trait>&    c,
+                  const SplitScreening<Trait>& s,
+                  size_t                       index,
+                  size_t                       x_index,
+                  const T&                     alpha)
+{
+    using float_type    = typename Trait::float_type;
+    using tid_container = typename SplitScreening<Trait>::tid_container;
+
+    thread_local tid_container           inside;
+    thread_local std::vector<float_type> q_rest, q_inside;
+
+    const auto& component = s.rows_of_component[index];
+
+    inside.clear();
+    intersection(s.rows_of_pattern[x_index], component, inside);
+
+    const size_t n        = c.data.num_rows(index);
+    const size_t n_inside = support_of_rows(c.data, inside);
+    const size_t n_rest   = n - n_inside;
+
+    if (n_inside == 0 || n_rest == 0) return false;
+
+    const size_t m = c.summary.size();
+    q_rest.resize(m);
+    q_inside.resize(m);
+    for (size_t i = 0; i < m; ++i)
+    {
+        const auto& rows = s.rows_of_pattern[i];
+        const auto  a    = support_of_intersection(c.data, rows, inside);
+        const auto  b    = support_of_intersection(c.data, rows, component);
+        q_inside[i]      = float_type(a) / n_inside;
+        q_rest[i]        = float_type(b - a) / n_rest;
+    }
+
+    return test_stat_divergence_of_columns(
+        m,
+        [&](size_t i) { return q_rest[i]; },
+        [&](size_t i) { return q_inside[i]; },
+        n,
+        alpha,
+        x_index);
+}
+
+} // namespace sd::disc
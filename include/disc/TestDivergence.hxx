@@ -6,6 +6,10 @@
 
 #include <boost/math/distributions.hpp> // chi-square
 
+#include <optional>
+#include <type_traits>
+#include <utility>
+
 namespace sd::disc
 {
 
@@ -48,6 +52,22 @@ std::pair<T, T> chi_squared_confidence_interval(const T& sd, const T& alpha, siz
     return {lower_limit, upper_limit};
 }
 
+/// the divergence of two frequency columns p(i) and q(i) of a summary with m patterns
+template <typename F, typename G>
+auto js_divergence_of_columns(size_t m, F&& p, G&& q, std::optional<size_t> x_index)
+{
+    using float_t = std::decay_t<decltype(p(size_t(0)))>;
+
+    IncrementalDescription<float_t> stat;
+
+    for (size_t i = 0; i < m; ++i)
+    {
+        if (x_index && i != *x_index) stat += js1(p(i), q(i));
+    }
+
+    return std::make_pair(stat.sum(), stat.sd());
+}
+
 // to test if p is differently distributed from p', it is sufficient to compare \poly and \poly'
 template <typename Trait>
 auto js_divergence(const Composition<Trait>& c,
@@ -55,17 +75,33 @@ auto js_divergence(const Composition<Trait>& c,
                    size_t                    second_index,
                    std::optional<size_t>     x_index = std::nullopt)
 {
-    using float_t = typename Composition<Trait>::float_type;
+    return js_divergence_of_columns(
+        c.summary.size(),
+        [&](size_t i) { return c.frequency(i, first_index); },
+        [&](size_t i) { return c.frequency(i, second_index); },
+        x_index);
+}
 
-    IncrementalDescription<float_t> stat;
+/// test_stat_divergence of two frequency columns p(i) and q(i) of a summary with m patterns,
+/// which describe n rows in total
+template <typename F, typename G, typename T>
+bool test_stat_divergence_of_columns(
+    size_t m, F&& p, G&& q, size_t n, const T& alpha, std::optional<size_t> x_index)
+{
+    auto [js, sd] = js_divergence_of_columns(m, p, q, x_index);
 
-    for (size_t i = 0; i < c.summary.size(); ++i)
+    using std::isinf, std::isnan;
+    if (isnan(js) || isinf(js))
     {
-        if (x_index && i != *x_index)
-            stat += js1(c.frequency(i, first_index), c.frequency(i, second_index));
+        return false;
     }
 
-    return std::make_pair(stat.sum(), stat.sd());
+    const size_t dof  = m - x_index.has_value() - 1;
+    const auto   div  = 2 * n * js;
+    const auto   pval = chi_squared_pvalue(div, dof);
+    const auto   ci   = chi_squared_confidence_interval(sd, alpha, dof);
+
+    return pval >= (T(1) - alpha) && (ci.first <= sd && sd <= ci.second);
 }
 
 template <typename Trait, typename T>
@@ -88,21 +124,13 @@ auto test_stat_divergence(const Composition<Trait>& c,
         return false;
     }
 
-    auto [js, sd] = js_divergence(c, first_index, second_index, x_index);
-
-    using std::isinf, std::isnan;
-    if (isnan(js) || isinf(js))
-    {
-        return false;
-    }
-
-    const size_t n    = c.data.subset(first_index).size() + c.data.subset(second_index).size();
-    const size_t dof  = c.summary.size() - x_index.has_value() - 1;
-    const auto   div  = 2 * n * js;
-    const auto   pval = chi_squared_pvalue(div, dof);
-    const auto   ci   = chi_squared_confidence_interval(sd, alpha, dof);
-
-    return pval >= (T(1) - alpha) && (ci.first <= sd && sd <= ci.second);
+    return test_stat_divergence_of_columns(
+        c.summary.size(),
+        [&](size_t i) { return c.frequency(i, first_index); },
+        [&](size_t i) { return c.frequency(i, second_index); },
+        c.data.num_rows(first_index) + c.data.num_rows(second_index),
+        alpha,
+        x_index);
 }
 
 } // namespace sd::disc
\ No newline at end of file
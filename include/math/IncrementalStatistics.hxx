@@ -2,6 +2,9 @@
 #include <cmath>
 #include <cstddef>
 #include <functional> // less
+#include <limits>
+
+#include <math/Summation.hxx>
 
 // http://en.wikipedia.org/wiki/Algorithms_for_calculating_variance
 
@@ -125,7 +128,7 @@ private:
     using SizeType  = size_t;
     IncrementalMinMax<T, CMP> mm;
     IncrementalStatistics<T>  stats;
-    ValueType                 total = 0;
+    CompensatedSum<T>         total;
 
 public:
     IncrementalDescription() {}
@@ -151,7 +154,7 @@ public:
     ValueType variance() const { return stats.variance(); }
     ValueType sd() const { return stats.sd(); }
     ValueType se() const { return stats.se(); }
-    ValueType sum() const { return total; }
+    ValueType sum() const { return total.value(); }
 
     void apply(ValueType x)
     {
@@ -171,7 +174,7 @@ public:
     {
         mm.reset();
         stats.reset();
-        total = 0;
+        total.reset();
     }
 };
 } // namespace sd
@@ -0,0 +1,120 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <type_traits>
+
+// https://en.wikipedia.org/wiki/Kahan_summation_algorithm#Further_enhancements
+
+namespace sd
+{
+
+/** Neumaier's compensated summation: carries the rounding error of every addition */
+template <class val = double>
+class CompensatedSum
+{
+public:
+    typedef val ValueType;
+
+private:
+    ValueType total        = 0;
+    ValueType compensation = 0;
+
+public:
+    CompensatedSum() {}
+
+    template <typename Iter>
+    CompensatedSum(Iter i, Iter j)
+    {
+        for (auto k = i; k != j; ++k)
+            apply(*k);
+    }
+
+    ValueType value() const { return total + compensation; }
+
+    void apply(ValueType x)
+    {
+        using std::abs;
+        const ValueType t = total + x;
+        if (abs(total) >= abs(x))
+            compensation += (total - t) + x;
+        else
+            compensation += (x - t) + total;
+        total = t;
+    }
+    void            operator()(ValueType x) { apply(x); }
+    CompensatedSum& operator+=(ValueType x)
+    {
+        apply(x);
+        return *this;
+    }
+    CompensatedSum& operator+=(const CompensatedSum& other)
+    {
+        apply(other.total);
+        compensation += other.compensation;
+        return *this;
+    }
+
+    void reset()
+    {
+        total        = 0;
+        compensation = 0;
+    }
+};
+
+template <typename Iter>
+auto compensated_sum(Iter i, Iter j)
+{
+    using T = std::decay_t<decltype(*i)>;
+    return CompensatedSum<T>(i, j).value();
+}
+
+/** Streaming log(sum_i exp(x_i)) that neither over- nor underflows in the terms */
+template <class val = double>
+class LogSumExp
+{
+public:
+    typedef val ValueType;
+
+private:
+    ValueType maximum = -std::numeric_limits<ValueType>::infinity();
+    ValueType scaled  = 0; // sum_i exp(x_i - maximum)
+
+public:
+    LogSumExp() {}
+
+    ValueType value() const
+    {
+        using std::log;
+        return scaled == 0 ? maximum : maximum + log(scaled);
+    }
+
+    void apply(ValueType x)
+    {
+        using std::exp;
+        if (!(x > -std::numeric_limits<ValueType>::infinity())) return;
+        if (x <= maximum)
+        {
+            scaled += exp(x - maximum);
+        }
+        else
+        {
+            scaled  = scaled * exp(maximum - x) + 1;
+            maximum = x;
+        }
+    }
+    void       operator()(ValueType x) { apply(x); }
+    LogSumExp& operator+=(ValueType x)
+    {
+        apply(x);
+        return *this;
+    }
+
+    void reset()
+    {
+        maximum = -std::numeric_limits<ValueType>::infinity();
+        scaled  = 0;
+    }
+};
+
+} // namespace sd
@@ -12,6 +12,34 @@ void select_dist_type(Fn&& fn)
     std::forward<Fn>(fn)(trait{});
 }
 
+/// is_relaxed selects the overlapping factorization of RelEntDistribution
+template <typename S, typename T, typename Fn>
+void select_dist_type(bool is_relaxed, Fn&& fn)
+{
+    if (is_relaxed)
+    {
+        using trait = Trait<S, T, RelEntDistribution<S, T>>;
+        std::forward<Fn>(fn)(trait{});
+    }
+    else
+    {
+        select_dist_type<S, T>(std::forward<Fn>(fn));
+    }
+}
+
+template <typename S, typename Fn>
+void select_real_type(bool is_precise, bool is_relaxed, Fn&& fn)
+{
+    if (is_precise)
+    {
+        select_dist_type<S, precise_float_t>(is_relaxed, std::forward<Fn>(fn));
+    }
+    else
+    {
+        select_dist_type<S, double>(is_relaxed, std::forward<Fn>(fn));
+    }
+}
+
 template <typename S, typename Fn>
 void select_real_type(bool is_precise, Fn&& fn)
 {
@@ -25,6 +53,19 @@ void select_real_type(bool is_precise, Fn&& fn)
     }
 }
 
+template <typename Fn>
+void build_trait(bool is_sparse, bool is_precise, bool is_relaxed, Fn&& fn)
+{
+    if (is_sparse)
+    {
+        select_real_type<tag_sparse>(is_precise, is_relaxed, std::forward<Fn>(fn));
+    }
+    else
+    {
+        select_real_type<tag_dense>(is_precise, is_relaxed, std::forward<Fn>(fn));
+    }
+}
+
 template <typename Fn>
 void build_trait(bool is_sparse, bool is_precise, Fn&& fn)
 {
@@ -211,6 +211,8 @@ py::dict desc_impl(Dataset<S>          dataset,
                    std::vector<size_t> labels,
                    size_t              min_support,
                    bool                beam_search,
+                   bool                log_space_scaling,
+                   bool                deduplicate,
                    BiMap&              tr)
 {
     using namespace sd::disc;
@@ -222,8 +224,13 @@ py::dict desc_impl(Dataset<S>          dataset,
     cfg.max_factor_width = 12;
     cfg.search_depth     = beam_search ? 10 : 1;
 
+    cfg.log_space_scaling = log_space_scaling;
+
     if (labels.size() != 0)
     {
+        std::vector<size_t> unique_of_row;
+        if (deduplicate) unique_of_row = deduplicate_rows(dataset, &labels);
+
         Composition<trait_type> c;
         c.data = PartitionedData<S>(std::move(dataset), std::move(labels));
 
@@ -233,10 +240,14 @@ py::dict desc_impl(Dataset<S>          dataset,
         auto encoding         = encode(c, cfg.use_bic);
         c.data.revert_order();
 
-        return translate_to_pydict(c, ms, initial_encoding, encoding, tr);
+        auto r = translate_to_pydict(c, ms, initial_encoding, encoding, tr);
+        if (deduplicate) r["labels"] = py::cast(expand_labels(c.data, unique_of_row));
+        return r;
     }
     else
     {
+        if (deduplicate) deduplicate_rows(dataset);
+
         Component<trait_type> c;
         c.data = std::move(dataset);
 
@@ -256,6 +267,9 @@ auto disc_impl(Dataset<typename trait_type::pattern_type>&& dataset,
                size_t                                       min_support,
                double                                       alpha,
                bool                                         beam_search,
+               bool                                         log_space_scaling,
+               bool                                         deduplicate,
+               bool                                         multi_split,
                BiMap&                                       tr)
 {
     using namespace sd::disc;
@@ -268,6 +282,12 @@ auto disc_impl(Dataset<typename trait_type::pattern_type>&& dataset,
     cfg.max_factor_width = 10;
     cfg.search_depth     = beam_search ? 10 : 1;
 
+    cfg.log_space_scaling = log_space_scaling;
+    cfg.multi_split       = multi_split;
+
+    std::vector<size_t> unique_of_row;
+    if (deduplicate) unique_of_row = deduplicate_rows(dataset);
+
     Composition<trait_type> c;
     c.data = PartitionedData<typename trait_type::pattern_type>(std::move(dataset));
     initialize_model(c, cfg);
@@ -279,7 +299,9 @@ auto disc_impl(Dataset<typename trait_type::pattern_type>&& dataset,
 
     c.data.revert_order();
 
-    return translate_to_pydict(c, ms, initial_encoding, encoding, tr);
+    auto r = translate_to_pydict(c, ms, initial_encoding, encoding, tr);
+    if (deduplicate) r["labels"] = py::cast(expand_labels(c.data, unique_of_row));
+    return r;
 }
 
 // template <typename S>
@@ -319,20 +341,26 @@ auto describe_partitions(const py::object& dataset,
                          size_t            min_support,
                          bool              is_sparse                   = false,
                          bool              use_higher_precision_floats = false,
-                         bool              beam_search                 = false)
+                         bool              beam_search                 = false,
+                         bool              use_relaxed_factorization   = false,
+                         bool              use_log_space_scaling       = false,
+                         bool              deduplicate_rows            = false)
 {
     py::dict r;
-    sd::disc::build_trait(is_sparse, use_higher_precision_floats, [&](auto trait) {
-        using T = decltype(trait);
-        using S = typename T::pattern_type;
-
-        BiMap tr;
-        r = pyutils::desc_impl<T>(create_dataset_pyobject<S>(dataset, tr),
-                                  py::cast<std::vector<size_t>>(labels),
-                                  min_support,
-                                  beam_search,
-                                  tr);
-    });
+    sd::disc::build_trait(
+        is_sparse, use_higher_precision_floats, use_relaxed_factorization, [&](auto trait) {
+            using T = decltype(trait);
+            using S = typename T::pattern_type;
+
+            BiMap tr;
+            r = pyutils::desc_impl<T>(create_dataset_pyobject<S>(dataset, tr),
+                                      py::cast<std::vector<size_t>>(labels),
+                                      min_support,
+                                      beam_search,
+                                      use_log_space_scaling,
+                                      deduplicate_rows,
+                                      tr);
+        });
     return r;
 }
 
@@ -341,16 +369,27 @@ auto discover_composition(const py::object& dataset,
                           double            alpha,
                           bool              is_sparse                   = false,
                           bool              use_higher_precision_floats = false,
-                          bool              beam_search                 = false)
+                          bool              beam_search                 = false,
+                          bool              use_relaxed_factorization   = false,
+                          bool              use_log_space_scaling       = false,
+                          bool              deduplicate_rows            = false,
+                          bool              multi_split                 = false)
 {
     py::dict r;
-    sd::disc::build_trait(is_sparse, use_higher_precision_floats, [&](auto trait) {
-        using T = decltype(trait);
-        using S = typename T::pattern_type;
-        BiMap tr;
-        r = pyutils::disc_impl<T>(
-            create_dataset_pyobject<S>(dataset, tr), min_support, alpha, beam_search, tr);
-    });
+    sd::disc::build_trait(
+        is_sparse, use_higher_precision_floats, use_relaxed_factorization, [&](auto trait) {
+            using T = decltype(trait);
+            using S = typename T::pattern_type;
+            BiMap tr;
+            r = pyutils::disc_impl<T>(create_dataset_pyobject<S>(dataset, tr),
+                                      min_support,
+                                      alpha,
+                                      beam_search,
+                                      use_log_space_scaling,
+                                      deduplicate_rows,
+                                      multi_split,
+                                      tr);
+        });
     return r;
 }
 
@@ -381,7 +420,10 @@ The pattern composition consists the following:
           "min_support"_a                 = 2,
           "is_sparse"_a                   = false,
           "use_higher_precision_floats"_a = false,
-          "beam_search"_a                 = false);
+          "beam_search"_a                 = false,
+          "use_relaxed_factorization"_a   = false,
+          "use_log_space_scaling"_a       = false,
+          "deduplicate_rows"_a            = false);
     m.def("disc",
           &discover_composition,
           "Discover differently distributed partitions that are characterized using patterns"
@@ -390,7 +432,11 @@ The pattern composition consists the following:
           "alpha"_a                       = 0.05,
           "is_sparse"_a                   = false,
           "use_higher_precision_floats"_a = false,
-          "beam_search"_a                 = false);
+          "beam_search"_a                 = false,
+          "use_relaxed_factorization"_a   = false,
+          "use_log_space_scaling"_a       = false,
+          "deduplicate_rows"_a            = false,
+          "multi_split"_a                 = false);
 
     m.attr("__version__") = "dev";
 }
\ No newline at end of file
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <desc/storage/Dataset.hxx>
+
+#include <random>
+
+namespace sd::disc
+{
+
+// every third row draws from one block of correlated items, the others from a second one
+template <typename S>
+Dataset<S> make_data(size_t rows, size_t dim, unsigned seed)
+{
+    std::mt19937                rng(seed);
+    std::bernoulli_distribution noise(0.2), signal(0.7);
+
+    Dataset<S> data;
+    itemset<S> t;
+    for (size_t i = 0; i < rows; ++i)
+    {
+        t.clear();
+        for (size_t j = 0; j < dim; ++j)
+        {
+            const bool in_block = (i % 3 == 0) ? j < 5 : (j >= 5 && j < 9);
+            if (in_block ? signal(rng) : noise(rng)) t.insert(j);
+        }
+        if (count(t) == 0) t.insert(dim - 1);
+        data.insert(t);
+    }
+    return data;
+}
+
+} // namespace sd::disc
@@ -1,6 +1,6 @@
 #include <TrivialTest.hxx>
 
-#include <disc/storage/Itemset.hxx>
+#include <desc/storage/Itemset.hxx>
 
 #include <random>
 
@@ -0,0 +1,124 @@
+#include <TestData.hxx>
+#include <TrivialTest.hxx>
+
+#include <desc/Desc.hxx>
+#include <disc/Disc.hxx>
+#include <disc/Encoding.hxx>
+
+#include <cmath>
+
+using namespace sd;
+using namespace sd::disc;
+
+using trait_type = Trait<tag_dense, double, MaxEntDistribution<tag_dense, double>>;
+
+DiscConfig make_config()
+{
+    DiscConfig cfg;
+    cfg.min_support      = 2;
+    cfg.max_factor_size  = 8;
+    cfg.max_factor_width = 10;
+    cfg.search_depth     = 1;
+    return cfg;
+}
+
+bool close(double a, double b) { return std::abs(a - b) <= 1e-9 * std::max(1.0, std::abs(a)); }
+
+bool same_summary(const Dataset<tag_dense>& a, const Dataset<tag_dense>& b)
+{
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i)
+    {
+        if (!sd::equal(a.point(i), b.point(i))) return false;
+    }
+    return true;
+}
+
+auto describe(bool dedup)
+{
+    const auto cfg = make_config();
+
+    Component<trait_type> c;
+    c.data = make_data<tag_dense>(600, 7, 1);
+    if (dedup) deduplicate_rows(c.data);
+    initialize_model(c, cfg);
+    discover_patterns_generic(c, cfg, IDesc{});
+    return c;
+}
+
+void test_desc()
+{
+    const auto plain = describe(false);
+    const auto dedup = describe(true);
+
+    TEST(dedup.data.size() < plain.data.size());
+    TEST(dedup.data.num_rows() == plain.data.size());
+
+    TEST(same_summary(plain.summary, dedup.summary));
+    TEST(plain.frequency.size() == dedup.frequency.size());
+    for (size_t i = 0; i < plain.frequency.size(); ++i)
+        TEST(close(plain.frequency[i], dedup.frequency[i]));
+
+    TEST(close(encode(plain, true).objective(), encode(dedup, true).objective()));
+}
+
+struct Decomposed
+{
+    Composition<trait_type> c;
+    double                  objective;
+    std::vector<size_t>     labels; // of the original rows
+};
+
+Decomposed decompose(bool dedup)
+{
+    const auto cfg = make_config();
+
+    auto                data = make_data<tag_dense>(300, 7, 2);
+    std::vector<size_t> unique_of_row;
+    if (dedup) unique_of_row = deduplicate_rows(data);
+
+    Decomposed r;
+    r.c.data = PartitionedData<tag_dense>(std::move(data));
+    initialize_model(r.c, cfg);
+    auto pm = [](auto& c, const auto& g) {
+        c.masks = construct_component_masks(c);
+        discover_patterns_generic(c, g, IDesc{});
+    };
+    r.objective = discover_components(r.c, cfg, pm, EmptyCallback{}).objective();
+
+    auto d = r.c.data;
+    d.revert_order();
+    if (dedup)
+        r.labels = expand_labels(d, unique_of_row);
+    else
+        for (size_t i = 0; i < d.size(); ++i) r.labels.push_back(d.label(i));
+    return r;
+}
+
+void test_disc()
+{
+    const auto plain = decompose(false);
+    const auto dedup = decompose(true);
+
+    TEST(dedup.c.data.size() < plain.c.data.size());
+    TEST(dedup.c.data.num_rows() == plain.c.data.size());
+
+    TEST(close(plain.objective, dedup.objective));
+    TEST(plain.c.data.num_components() > 1);
+    TEST(plain.c.data.num_components() == dedup.c.data.num_components());
+    TEST(plain.labels == dedup.labels);
+
+    TEST(same_summary(plain.c.summary, dedup.c.summary));
+    for (size_t j = 0; j < plain.c.data.num_components(); ++j)
+    {
+        TEST(plain.c.data.num_rows(j) == dedup.c.data.num_rows(j));
+        for (size_t i = 0; i < plain.c.summary.size(); ++i)
+            TEST(close(plain.c.frequency(i, j), dedup.c.frequency(i, j)));
+    }
+}
+
+int main(void)
+{
+    test_desc();
+    test_disc();
+}
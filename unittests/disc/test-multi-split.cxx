@@ -0,0 +1,72 @@
+#include <TrivialTest.hxx>
+
+#include <desc/Desc.hxx>
+#include <disc/Disc.hxx>
+#include <disc/Encoding.hxx>
+
+#include <random>
+
+using namespace sd;
+using namespace sd::disc;
+
+// rows of four groups: the first bit of the group selects one of two blocks of items, the
+// second bit one of two smaller blocks within the half of the first one
+Dataset<tag_dense> make_groups(size_t rows, unsigned seed, std::vector<size_t>& halves)
+{
+    std::mt19937                rng(seed);
+    std::bernoulli_distribution noise(0.05), signal(0.9);
+
+    Dataset<tag_dense> data;
+    itemset<tag_dense> t;
+    halves.resize(rows);
+    for (size_t i = 0; i < rows; ++i)
+    {
+        const size_t a = i % 2, g = (i / 2) % 2;
+        t.clear();
+        for (size_t j = 0; j < 24; ++j)
+        {
+            const bool in_block = j / 6 == a || (j >= 12 && (j - 12) / 3 == 2 * a + g);
+            if (in_block ? signal(rng) : noise(rng)) t.insert(j);
+        }
+        data.insert(t);
+        halves[i] = a;
+    }
+    return data;
+}
+
+// one step of disc, starting from the first split, so that both halves can be split next
+auto step_after_first_split(bool multi_split)
+{
+    DiscConfig cfg;
+    cfg.min_support      = 2;
+    cfg.max_factor_size  = 8;
+    cfg.max_factor_width = 10;
+    cfg.search_depth     = 1;
+    cfg.multi_split      = multi_split;
+
+    std::vector<size_t> halves;
+    auto                data = make_groups(400, 3, halves);
+
+    Composition<Trait<tag_dense, double, MaxEntDistribution<tag_dense, double>>> c;
+    c.data = PartitionedData<tag_dense>(std::move(data), halves);
+    initialize_model(c, cfg);
+    c.masks = construct_component_masks(c);
+    discover_patterns_generic(c, cfg, IDesc{});
+
+    auto                     encoding = encode(c, cfg.use_bic);
+    RejectedSplits           rejected;
+    SplitScreeningStatistics screening;
+    TEST(disc_decomp_step(c, cfg, encoding, rejected, screening));
+    return std::pair{c.data.num_components(), encoding.objective()};
+}
+
+int main(void)
+{
+    const auto [k_single, l_single] = step_after_first_split(false);
+    const auto [k_multi, l_multi]   = step_after_first_split(true);
+
+    // both halves have a significant split, which are accepted together
+    TEST(k_single == 3);
+    TEST(k_multi == 4);
+    TEST(l_multi < l_single);
+}
@@ -0,0 +1,78 @@
+#include <TestData.hxx>
+#include <TrivialTest.hxx>
+
+#include <desc/Desc.hxx>
+#include <disc/Disc.hxx>
+
+using namespace sd;
+using namespace sd::disc;
+
+using trait_type = Trait<tag_dense, double, MaxEntDistribution<tag_dense, double>>;
+
+// the first half of the rows mixes the blocks, so that most patterns split it. the second
+// half is split by its blocks, which leaves little to split
+Composition<trait_type> make_composition(bool dedup)
+{
+    DiscConfig cfg;
+    cfg.min_support      = 2;
+    cfg.max_factor_size  = 8;
+    cfg.max_factor_width = 10;
+
+    auto                data = make_data<tag_dense>(600, 9, 7);
+    std::vector<size_t> labels(data.size());
+    for (size_t i = 0; i < labels.size(); ++i) labels[i] = i < 300 ? 0 : 1 + (i % 3 == 0);
+    if (dedup) deduplicate_rows(data, &labels);
+
+    Composition<trait_type> c;
+    c.data = PartitionedData<tag_dense>(std::move(data), labels);
+    initialize_model(c, cfg);
+    c.masks = construct_component_masks(c);
+    discover_patterns_generic(c, cfg, IDesc{});
+    return c;
+}
+
+// screen_split has to decide every split of c as the test of disc_decomp_step does after
+// split_component and compute_frequency_matrix
+void check_screening(const Composition<trait_type>& c)
+{
+    // corrected for the number of splits, as in disc_decomp_step
+    const double alpha     = 0.05 / (c.data.num_components() * c.summary.size());
+    const auto   screening = prepare_split_screening(c);
+
+    size_t passed = 0, failed = 0;
+    for (size_t i = 0; i < c.data.num_components(); ++i)
+    {
+        for (size_t j = 0; j < c.summary.size(); ++j)
+        {
+            const bool screened = screen_split(c, screening, i, j, alpha);
+
+            auto next = c;
+            split_component(next, i, c.summary.point(j), c.data.num_components() + 1);
+            if (next.data.num_components() <= c.data.num_components())
+            {
+                TEST(!screened);
+                continue;
+            }
+            compute_frequency_matrix(next);
+
+            const size_t last = next.data.num_components() - 1;
+            TEST(next.data.num_rows(i) + next.data.num_rows(last) == c.data.num_rows(i));
+            TEST(screened == test_stat_divergence(next, alpha, i, last, j));
+            screened ? ++passed : ++failed;
+        }
+    }
+    TEST(passed > 0 && failed > 0);
+}
+
+int main(void)
+{
+    const auto plain = make_composition(false);
+    const auto dedup = make_composition(true);
+
+    TEST(!plain.data.is_weighted());
+    TEST(dedup.data.is_weighted() && dedup.data.size() < plain.data.size());
+    TEST(plain.summary.size() > 9);
+
+    check_screening(plain);
+    check_screening(dedup);
+}
@@ -0,0 +1,106 @@
+#include <TestData.hxx>
+#include <TrivialTest.hxx>
+
+#include <desc/distribution/Distribution.hxx>
+
+using namespace sd;
+using namespace sd::disc;
+
+template <typename S>
+double frequency(const Dataset<S>& data, const itemset<S>& x)
+{
+    size_t n = 0;
+    for (size_t r = 0; r < data.size(); ++r) n += is_subset(x, data.point(r));
+    return double(n) / data.size();
+}
+
+template <typename S>
+itemset<S> make_range(size_t first, size_t last)
+{
+    itemset<S> t;
+    for (size_t i = first; i < last; ++i) t.insert(i);
+    return t;
+}
+
+// a narrow factor over the first block, and a factor wider than max_table_width
+template <typename Model, typename S>
+void insert_patterns(Model& m, const Dataset<S>& data)
+{
+    for (size_t i = 0; i < m.dimension(); ++i)
+    {
+        m.insert_singleton(frequency(data, make_range<S>(i, i + 1)), i, true);
+    }
+
+    for (const auto& t : {make_range<S>(0, 3), make_range<S>(1, 4), make_range<S>(5, 8)})
+    {
+        m.insert(frequency(data, t), t, true);
+    }
+
+    itemset<S> wide = make_range<S>(5, 9);
+    for (size_t i = 9; i < m.dimension(); ++i) wide.insert(i);
+    m.insert(frequency(data, wide), wide, true);
+}
+
+void test_tables()
+{
+    const size_t dim  = 24;
+    const auto   data = make_data<tag_dense>(400, dim, 4);
+
+    StaticFactorModel<tag_dense, double> m(dim);
+    m.max_factor_size  = 8;
+    m.max_factor_width = dim;
+    insert_patterns(m, data);
+
+    size_t widest = 0;
+    for (const auto& f : m.phi.factors) widest = std::max(widest, f.factor.singletons.size());
+    TEST(m.phi.factors.size() == 2);
+    TEST(widest > max_table_width);
+
+    // the rows that were not compiled have to fall back to the factors
+    FactorTables<double> lut;
+    const auto           half = data.begin() + data.size() / 2;
+    compile_factor_tables(m, lut, data.begin(), half, true);
+
+    for (const auto& x : data)
+    {
+        TEST(log_expectation(m, lut, point(x)) == log_expectation(m, point(x)));
+    }
+
+    compile_factor_tables(m, lut, half, data.end(), false);
+    for (const auto& x : data)
+    {
+        TEST(log_expectation(m, lut, point(x)) == log_expectation(m, point(x)));
+    }
+}
+
+// the rows span more than one batch, and the tables are compiled again after an insert
+void test_score_rows()
+{
+    const size_t dim  = 24;
+    const auto   data = make_data<tag_dense>(700, dim, 6);
+
+    MaxEntDistribution<tag_dense, double> d(dim, data.size(), 8, dim);
+    insert_patterns(d, data);
+
+    const auto check = [&](auto first, auto last) {
+        std::vector<double> scores(last - first);
+        score_rows(d, first, last, scores.begin());
+        for (size_t k = 0; k < scores.size(); ++k)
+        {
+            TEST(scores[k] == d.log_expectation(point(*(first + k))));
+        }
+    };
+
+    check(data.begin() + 5, data.end());
+    check(data.begin(), data.end());
+
+    const auto t = make_range<tag_dense>(1, 3);
+    d.insert(frequency(data, t), t, true);
+    check(data.begin(), data.end());
+}
+
+int main(void)
+{
+    test_tables();
+    test_score_rows();
+}
@@ -0,0 +1,87 @@
+#include <TestData.hxx>
+#include <TrivialTest.hxx>
+
+#include <desc/Component.hxx>
+#include <desc/Desc.hxx>
+#include <desc/utilities/BoostMultiprecision.hxx>
+#include <disc/Encoding.hxx>
+#include <math/Summation.hxx>
+
+#include <cmath>
+
+using namespace sd;
+using namespace sd::disc;
+
+void test_summation()
+{
+    // every single addition of the small terms is lost to rounding in plain double
+    const double  small = 1e-16;
+    const size_t  n     = 1000000;
+    double        naive = 1;
+    CompensatedSum<double> sum;
+    sum += 1.0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        naive += small;
+        sum += small;
+    }
+    const double exact = static_cast<double>(precise_float_t(1) + precise_float_t(small) * n);
+    TEST(naive == 1);
+    TEST(std::abs(sum.value() - exact) <= 1e-15 * exact);
+
+    LogSumExp<double> lse;
+    TEST(std::isinf(lse.value()) && lse.value() < 0);
+    lse += -1000;
+    lse += -1000;
+    TEST(std::abs(lse.value() - (-1000 + std::log(2.0))) < 1e-12);
+    lse.reset();
+    lse += 800;
+    lse += 0;
+    TEST(std::abs(lse.value() - 800) < 1e-12);
+}
+
+template <typename T>
+auto describe(bool log_space)
+{
+    Config cfg;
+    cfg.min_support       = 2;
+    cfg.max_factor_size   = 8;
+    cfg.max_factor_width  = 10;
+    cfg.log_space_scaling = log_space;
+
+    Component<Trait<tag_dense, T, MaxEntDistribution<tag_dense, T>>> c;
+    c.data = make_data<tag_dense>(200, 12, 1);
+    initialize_model(c, cfg);
+    discover_patterns_generic(c, cfg, IDesc{});
+    return c;
+}
+
+void test_against_float128()
+{
+    const auto reference = describe<precise_float_t>(false);
+
+    for (bool log_space : {false, true})
+    {
+        const auto c = describe<double>(log_space);
+
+        TEST(c.summary.size() == reference.summary.size());
+
+        const double l = log_likelihood(c.model, c.data);
+        const double r = static_cast<double>(log_likelihood(reference.model, reference.data));
+        TEST(std::abs(l - r) <= 1e-9 * r);
+
+        for (size_t i = 0; i < c.summary.size(); ++i)
+        {
+            const auto& x = c.summary.point(i);
+            const auto  p = static_cast<double>(c.model.expectation(x));
+            const auto  q = static_cast<double>(reference.model.expectation(x));
+            TEST(std::abs(p - q) <= 1e-7);
+        }
+    }
+}
+
+int main(void)
+{
+    test_summation();
+    test_against_float128();
+}
@@ -0,0 +1,162 @@
+#include <TestData.hxx>
+#include <TrivialTest.hxx>
+
+#include <desc/Component.hxx>
+#include <desc/Desc.hxx>
+#include <desc/distribution/Distribution.hxx>
+
+#include <cmath>
+
+using namespace sd;
+using namespace sd::disc;
+
+template <typename S, typename... Args>
+itemset<S> make_itemset(Args... args)
+{
+    itemset<S> t;
+    (t.insert(args), ...);
+    return t;
+}
+
+double frequency_of(const itemset<tag_dense>& t)
+{
+    double p = 1;
+    foreach (t, [&](size_t i) { p *= 0.1 + 0.04 * i; })
+        ;
+    return p;
+}
+
+template <typename Model>
+void insert_patterns(Model& m, const std::vector<itemset<tag_dense>>& patterns)
+{
+    for (size_t i = 0; i < m.dimension(); ++i)
+    {
+        m.insert_singleton(frequency_of(make_itemset<tag_dense>(i)), i, true);
+    }
+    for (const auto& t : patterns) m.insert(frequency_of(t), t, true);
+}
+
+// the parts of the cover are disjoint, so every item is counted once, even if two factors of
+// the cover contain it. the tables have to give the same sums.
+template <typename Model, typename Data>
+void check_rows(const Model& m, const Data& data)
+{
+    FactorTables<double> lut;
+    compile_factor_tables(m, lut, data.begin(), data.end(), true);
+
+    itemset<tag_dense> covered;
+    for (const auto& x : data)
+    {
+        const auto& y = point(x);
+
+        double sum = 0;
+        size_t n   = 0;
+        covered.clear();
+        factorize_dynamically_into_parts(
+            m.phi, y, [&](const auto& f, size_t, bool, const auto& part) {
+                TEST(!intersects(covered, part));
+                covered.insert(part);
+                n += count(part);
+                if constexpr (is_singleton_factor<std::decay_t<decltype(f)>>)
+                    sum += std::log2(f.probability);
+                else
+                    sum += std::log2(expectation(f.factor, part));
+            });
+        TEST(n == count(y) && is_subset(y, covered));
+
+        const double l = log_expectation(m, y);
+        TEST(l == sum);
+        TEST(log_expectation(m, lut, y) == l);
+    }
+}
+
+void test_overlapping_factors()
+{
+    const auto a = make_itemset<tag_dense>(0, 1, 2);
+    const auto b = make_itemset<tag_dense>(2, 3, 4);
+    const auto c = make_itemset<tag_dense>(5, 6);
+
+    const auto data = make_data<tag_dense>(200, 20, 5);
+
+    RelaxedFactorModel<tag_dense, double> m(20);
+    insert_patterns(m, {a, b, c});
+
+    // b is joined with the factor of a, which stays: items 0 to 2 have two factors
+    TEST(m.phi.factors.size() == 3);
+    TEST(is_subset(a, m.phi.factors[0].range) && is_subset(a, m.phi.factors[1].range));
+
+    TEST(!m.is_allowed(a));
+    TEST(m.is_allowed(make_itemset<tag_dense>(0, 1)));
+    TEST(m.is_allowed(make_itemset<tag_dense>(4, 5)));
+    TEST(!m.is_allowed(make_itemset<tag_dense>(4, 5), 5, 5));
+    TEST(!m.is_allowed(make_itemset<tag_dense>(0, 1), 1, 8));
+
+    check_rows(m, data);
+
+    // wider than max_table_width, so the tables have to fall back to the factor
+    m.max_factor_width = 24;
+    auto wide          = make_itemset<tag_dense>();
+    for (size_t i = 3; i < 20; ++i) wide.insert(i);
+    TEST(m.is_allowed(wide));
+    m.insert(frequency_of(wide), wide, true);
+    TEST(m.phi.factors.back().factor.singletons.size() > max_table_width);
+
+    check_rows(m, data);
+}
+
+void test_disjoint_factors_against_static()
+{
+    const auto a = make_itemset<tag_dense>(0, 1, 2);
+    const auto c = make_itemset<tag_dense>(5, 6, 8);
+
+    RelaxedFactorModel<tag_dense, double> m(12);
+    StaticFactorModel<tag_dense, double>  s(12);
+    insert_patterns(m, {a, c});
+    insert_patterns(s, {a, c});
+
+    for (const auto& x : make_data<tag_dense>(100, 12, 9))
+    {
+        const auto& y = point(x);
+        TEST(std::abs(log_expectation(m, y) - log_expectation(s, y)) <= 1e-12);
+        TEST(std::abs(log_probability(m, y) - log_probability(s, y)) <= 1e-12);
+        TEST(log_probability_of_absent_items(m, y) == log_probability_of_absent_items(s, y));
+    }
+}
+
+void test_mining_is_bounded()
+{
+    Config cfg;
+    cfg.min_support      = 2;
+    cfg.max_factor_size  = 5;
+    cfg.max_factor_width = 8;
+
+    Component<Trait<tag_dense, double, RelEntDistribution<tag_dense, double>>> c;
+    c.data = make_data<tag_dense>(300, 14, 2);
+    initialize_model(c, cfg);
+    discover_patterns_generic(c, cfg, IDesc{});
+
+    const auto& m = c.model.model;
+    TEST(m.phi.factors.size() <= c.summary.size());
+    for (const auto& f : m.phi.factors)
+    {
+        TEST(f.factor.itemsets.size() <= cfg.max_factor_size);
+        TEST(f.factor.singletons.size() <= cfg.max_factor_width);
+    }
+    for (size_t i = 0; i < c.summary.size(); ++i)
+    {
+        if (!is_singleton(c.summary.point(i))) TEST(!m.is_allowed(c.summary.point(i)));
+    }
+
+    c.model.compile_tables(c.data);
+    for (const auto& x : c.data)
+    {
+        TEST(c.model.log_expectation_of_row(point(x)) == c.model.log_expectation(point(x)));
+    }
+}
+
+int main(void)
+{
+    test_overlapping_factors();
+    test_disjoint_factors_against_static();
+    test_mining_is_bounded();
+}
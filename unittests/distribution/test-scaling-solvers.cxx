@@ -0,0 +1,77 @@
+#include <TestData.hxx>
+#include <TrivialTest.hxx>
+
+#include <desc/distribution/IterativeScaling.hxx>
+
+#include <cmath>
+
+using namespace sd;
+using namespace sd::disc;
+
+template <typename S>
+auto make_factor(const Dataset<S>& data, size_t width, const std::vector<itemset<S>>& patterns)
+{
+    const auto frequency = [&](const itemset<S>& x) {
+        size_t n = 0;
+        for (size_t r = 0; r < data.size(); ++r) n += is_subset(x, data.point(r));
+        return double(n) / data.size();
+    };
+
+    MaxEntFactor<S, double> f(width);
+    itemset<S>              x;
+    for (size_t j = 0; j < width; ++j)
+    {
+        x.clear();
+        x.insert(j);
+        f.insert(frequency(x), x, false);
+    }
+    for (const auto& y : patterns) f.insert(frequency(y), y, false);
+    return f;
+}
+
+void test_newton_against_iterative_scaling()
+{
+    // automatic solver selection goes by factor size only; both solvers have to reach the
+    // same solution, on overlapping, strongly correlated itemsets in particular
+    const auto data = make_data<tag_dense>(300, 12, 3);
+
+    std::vector<itemset<tag_dense>> patterns(4);
+    patterns[0].insert(0), patterns[0].insert(1);
+    patterns[1].insert(0), patterns[1].insert(1), patterns[1].insert(2);
+    patterns[2].insert(1), patterns[2].insert(2), patterns[2].insert(3);
+    patterns[3].insert(4), patterns[3].insert(5), patterns[3].insert(6);
+
+    IterativeScalingSettings<double> opts;
+    opts.max_iteration = 10000;
+
+    opts.solver  = ScalingSolver::iterative_scaling;
+    auto scaling = make_factor(data, 8, patterns);
+    estimate_model(scaling, opts);
+
+    opts.solver = ScalingSolver::newton;
+    auto newton = make_factor(data, 8, patterns);
+    estimate_model(newton, opts);
+
+    opts.solver    = ScalingSolver::automatic;
+    auto automatic = make_factor(data, 8, patterns);
+    estimate_model(automatic, opts);
+
+    TEST(scaling.size() == newton.size());
+    for (size_t i = 0; i < scaling.size(); ++i)
+    {
+        TEST(std::abs(scaling.probability(i) - scaling.frequency(i)) <= 1e-7);
+        TEST(std::abs(newton.probability(i) - newton.frequency(i)) <= 1e-7);
+        TEST(std::abs(newton.coefficient(i) - scaling.coefficient(i)) <=
+             1e-5 * scaling.coefficient(i));
+        TEST(automatic.coefficient(i) == newton.coefficient(i));
+    }
+
+    itemset<tag_dense> x;
+    x.insert(0), x.insert(2), x.insert(3), x.insert(5);
+    TEST(std::abs(expectation(newton, x) - expectation(scaling, x)) <= 1e-7);
+}
+
+int main(void)
+{
+    test_newton_against_iterative_scaling();
+}
@@ -0,0 +1,121 @@
+#include <TestData.hxx>
+#include <TrivialTest.hxx>
+
+#include <desc/storage/Dataset.hxx>
+
+#include <random>
+
+using namespace sd;
+using namespace sd::disc;
+
+std::vector<size_t> make_labels(size_t n, size_t k, size_t offset, unsigned seed)
+{
+    std::mt19937                          rng(seed);
+    std::uniform_int_distribution<size_t> pick(0, k - 1);
+
+    std::vector<size_t> labels(n);
+    for (auto& l : labels) l = offset + 10 * pick(rng);
+    return labels;
+}
+
+template <typename S>
+bool same_rows(const PartitionedData<S>& a, const PartitionedData<S>& b)
+{
+    if (a.size() != b.size() || a.positions != b.positions) return false;
+    if (a.component_labels != b.component_labels) return false;
+    if (a.cumulative_weights != b.cumulative_weights) return false;
+    for (size_t i = 0; i < a.size(); ++i)
+    {
+        if (a.label(i) != b.label(i) || a.original_position(i) != b.original_position(i))
+            return false;
+    }
+    return true;
+}
+
+template <typename S>
+void check_grouping(const PartitionedData<S>& data)
+{
+    TEST(data.positions.front() == 0 && data.positions.back() == data.size());
+    TEST(data.component_labels.size() == data.num_components());
+    TEST(data.is_grouped(0, data.component_labels[0]));
+    for (size_t j = 0; j < data.num_components(); ++j)
+    {
+        if (j > 0) TEST(data.component_labels[j - 1] < data.component_labels[j]);
+        // stable: the rows of a component keep their original order
+        for (size_t i = data.positions[j] + 1; i < data.positions[j + 1]; ++i)
+            TEST(data.original_position(i - 1) < data.original_position(i));
+    }
+}
+
+void test_group_by_label()
+{
+    const size_t n = 300;
+
+    // small labels are counted, labels far beyond the number of rows are sorted
+    const auto small = make_labels(n, 5, 0, 1);
+    auto       large = small;
+    for (auto& l : large) l += 1'000'000'000;
+
+    PartitionedData<tag_dense> counted(make_data<tag_dense>(n, 16, 1), small);
+    PartitionedData<tag_dense> sorted(make_data<tag_dense>(n, 16, 1), large);
+
+    check_grouping(counted);
+    check_grouping(sorted);
+
+    TEST(counted.num_components() == 5);
+    TEST(sorted.num_components() == counted.num_components());
+    for (size_t i = 0; i < n; ++i)
+    {
+        TEST(sorted.label(i) == counted.label(i) + 1'000'000'000);
+        TEST(sorted.original_position(i) == counted.original_position(i));
+    }
+
+    // relabeled rows do not change the ids of the components until they are regrouped
+    const auto ids = counted.component_labels;
+    counted.label(0) = counted.component_labels.back();
+    TEST(counted.component_labels == ids);
+}
+
+template <typename S>
+void check_split(const PartitionedData<S>& grouped, size_t index, size_t every)
+{
+    const size_t label = grouped.component_labels.back() + 1;
+
+    auto split = grouped;
+    for (size_t i = split.positions[index]; i < split.positions[index + 1]; ++i)
+    {
+        if (split.original_position(i) % every == 0) split.label(i) = label;
+    }
+    auto regrouped = split;
+
+    split.group_split(index, label);
+    regrouped.group_by_label();
+
+    TEST(same_rows(split, regrouped));
+    check_grouping(split);
+}
+
+void test_group_split()
+{
+    const size_t n = 300;
+
+    auto data = make_data<tag_dense>(n, 8, 2);
+    auto ls   = make_labels(n, 4, 3, 2);
+    deduplicate_rows(data, &ls);
+
+    PartitionedData<tag_dense> grouped(std::move(data), ls);
+    TEST(grouped.is_weighted());
+
+    for (size_t index = 0; index < grouped.num_components(); ++index)
+    {
+        check_split(grouped, index, 3);
+        check_split(grouped, index, 1); // dissolves the component
+        check_split(grouped, index, n); // moves the first row of the data, if anything
+    }
+}
+
+int main(void)
+{
+    test_group_by_label();
+    test_group_split();
+}